@@ -0,0 +1,41 @@
+#ifndef GROUP56_WORK_ANALYSISBUDGET_H
+#define GROUP56_WORK_ANALYSISBUDGET_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// How long an analysis pass may run. It is cancelled as soon as a shared
+// generation counter moves past the generation of the text it works on, and
+// out of time at its deadline. Passes check every kCheckBytes or so of text,
+// which keeps the checks off the profile while still stopping well within a
+// millisecond.
+class AnalysisBudget {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t kCheckBytes = 4096;
+
+    // Never cancelled, never out of time
+    AnalysisBudget() = default;
+
+    AnalysisBudget(const std::atomic<uint64_t>* latest, uint64_t generation,
+                   Clock::time_point deadline = Clock::time_point::max())
+            : m_latest(latest), m_generation(generation), m_deadline(deadline) {}
+
+    // The text is outdated; nothing the pass produces is wanted any more
+    bool Cancelled() const {
+        return m_latest && m_latest->load(std::memory_order_relaxed) != m_generation;
+    }
+
+    // Cancelled, or past the deadline: what is done so far is still wanted
+    bool Exhausted() const {
+        return Cancelled() || (m_deadline != Clock::time_point::max() && Clock::now() >= m_deadline);
+    }
+
+private:
+    const std::atomic<uint64_t>* m_latest = nullptr;
+    uint64_t m_generation = 0;
+    Clock::time_point m_deadline = Clock::time_point::max();
+};
+
+#endif //GROUP56_WORK_ANALYSISBUDGET_H
@@ -0,0 +1,74 @@
+#ifndef GROUP56_WORK_ANALYSISSCHEDULER_H
+#define GROUP56_WORK_ANALYSISSCHEDULER_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+
+// Counters showing how well bursts of edits are coalesced
+struct SchedulerStats {
+    uint64_t eventsReceived = 0;  // modification notifications
+    uint64_t analysesRun = 0;     // jobs handed to the worker
+    uint64_t resultsApplied = 0;
+    uint64_t resultsDropped = 0;  // stale by the time they arrived
+    uint64_t passesCancelled = 0; // given up by the worker for newer text
+};
+
+// Decides when coalesced edits get analysed: once no edit has arrived for
+// the quiet period, or at the latest maxStaleness after the first edit that
+// has not been analysed yet, so highlighting never lags further than that.
+class AnalysisScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void SetQuietPeriod(std::chrono::milliseconds period) { m_quietPeriod = period; }
+    void SetMaxStaleness(std::chrono::milliseconds staleness) { m_maxStaleness = staleness; }
+
+    void NoteEdit(Clock::time_point now) {
+        m_stats.eventsReceived++;
+        if (!m_pending) m_firstEdit = now;
+        m_lastEdit = now;
+        m_pending = true;
+    }
+
+    void NoteAnalysisRun() {
+        m_stats.analysesRun++;
+        m_pending = false;
+    }
+
+    void NoteResult(bool applied) {
+        if (applied) {
+            m_stats.resultsApplied++;
+        } else {
+            m_stats.resultsDropped++;
+        }
+    }
+
+    void NoteCancelled() { m_stats.passesCancelled++; }
+
+    bool IsPending() const { return m_pending; }
+
+    bool IsDue(Clock::time_point now) const {
+        return m_pending && (now - m_lastEdit >= m_quietPeriod || now - m_firstEdit >= m_maxStaleness);
+    }
+
+    // How long until IsDue turns true if no further edits arrive
+    std::chrono::milliseconds TimeUntilDue(Clock::time_point now) const {
+        using std::chrono::duration_cast;
+        auto quiet = duration_cast<std::chrono::milliseconds>(m_lastEdit + m_quietPeriod - now);
+        auto stale = duration_cast<std::chrono::milliseconds>(m_firstEdit + m_maxStaleness - now);
+        return std::max(std::min(quiet, stale), std::chrono::milliseconds(0));
+    }
+
+    const SchedulerStats& Stats() const { return m_stats; }
+
+private:
+    std::chrono::milliseconds m_quietPeriod{30};
+    std::chrono::milliseconds m_maxStaleness{200};
+    Clock::time_point m_firstEdit;
+    Clock::time_point m_lastEdit;
+    bool m_pending = false;
+    SchedulerStats m_stats;
+};
+
+#endif //GROUP56_WORK_ANALYSISSCHEDULER_H
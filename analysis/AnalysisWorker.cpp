@@ -0,0 +1,86 @@
+#include "AnalysisWorker.h"
+
+AnalysisWorker::AnalysisWorker(ResultCallback onResult, ThreadPool& pool)
+        : m_onResult(std::move(onResult)), m_analyzer(pool), m_thread(&AnalysisWorker::Run, this) {}
+
+AnalysisWorker::~AnalysisWorker() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+}
+
+void AnalysisWorker::Submit(AnalysisJob job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_pending) {
+            // The waiting job is outdated, but its edits must still be replayed
+            auto& edits = m_pending->edits;
+            edits.insert(edits.end(), job.edits.begin(), job.edits.end());
+            job.edits = std::move(edits);
+            job.resync = job.resync || m_pending->resync;
+            job.reset = job.reset || m_pending->reset;
+        }
+        m_latest.store(job.generation, std::memory_order_relaxed);
+        m_pending = std::move(job);
+    }
+    m_wake.notify_one();
+}
+
+void AnalysisWorker::Cancel(uint64_t generation) {
+    m_latest.store(generation, std::memory_order_relaxed);
+}
+
+void AnalysisWorker::SetViewport(const TextRange& viewport, size_t sliceBytes) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_viewport = viewport;
+        m_sliceBytes = sliceBytes;
+        m_viewportChanged = true;
+    }
+    m_wake.notify_one();
+}
+
+void AnalysisWorker::Run() {
+    // The snapshot the backlog refers to
+    std::shared_ptr<const std::string> text;
+    uint64_t generation = 0;
+
+    while (true) {
+        std::optional<AnalysisJob> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] {
+                return m_stopping || m_pending || m_viewportChanged ||
+                       (text && m_analyzer.HasBacklog() && m_latest.load(std::memory_order_relaxed) == generation);
+            });
+            if (m_stopping) return;
+            if (m_viewportChanged) {
+                m_analyzer.SetViewport(m_viewport, m_sliceBytes);
+                m_viewportChanged = false;
+            }
+            job.swap(m_pending);
+        }
+
+        if (job) {
+            if (job->reset) m_analyzer.Reset();
+            for (const auto& edit : job->edits) m_analyzer.ApplyEdit(edit);
+            if (job->resync) m_analyzer.Invalidate(job->snapshot->size());
+            AnalysisBudget budget(&m_latest, job->generation, AnalysisBudget::Clock::now() + kResultTime);
+            AnalysisResult result = m_analyzer.Analyse(*job->snapshot, job->dirty, job->firstLine, job->lineCount,
+                                                       budget);
+            result.generation = job->generation;
+            text = job->snapshot;
+            generation = job->generation;
+            m_onResult(std::move(result));
+        } else if (text && m_analyzer.HasBacklog() && m_latest.load(std::memory_order_relaxed) == generation) {
+            // Nothing newer to do: one more slice, then check again
+            AnalysisBudget budget(&m_latest, generation, AnalysisBudget::Clock::now() + kResultTime);
+            AnalysisResult result = m_analyzer.NextSlice(*text, budget);
+            result.generation = generation;
+            m_onResult(std::move(result));
+        }
+    }
+}
@@ -0,0 +1,75 @@
+#ifndef GROUP56_WORK_ANALYSISWORKER_H
+#define GROUP56_WORK_ANALYSISWORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include "DocumentAnalyzer.h"
+
+// Everything the worker needs to analyse one version of the document
+struct AnalysisJob {
+    uint64_t generation = 0;
+    std::shared_ptr<const std::string> snapshot;  // immutable copy of the buffer
+    std::vector<EditRecord> edits;                // edits since the previous job
+    TextRange dirty;                              // in snapshot coordinates
+    int firstLine = 0;
+    int lineCount = 1;
+    bool resync = false;  // an earlier result never reached the screen
+    bool reset = false;   // edits went unrecorded; start over from the snapshot
+};
+
+// Runs DocumentAnalyzer on a background thread. Only the newest job is kept:
+// a job submitted while another is still waiting replaces it, carrying its
+// edits along. While no job is waiting, the analyzer's highlight backlog is
+// worked off one slice at a time, each slice posted as a result of its own.
+// Results are handed to the callback on the worker thread.
+//
+// Work on a snapshot stops within a millisecond once Cancel reports newer
+// text, and its result is posted marked cancelled. Highlighting also stops
+// after kResultTime per result, leaving the rest on the backlog, so the UI
+// thread gets it in small pieces and a new job never waits long behind it.
+class AnalysisWorker {
+public:
+    using ResultCallback = std::function<void(AnalysisResult)>;
+
+    // The analysis passes are split over `pool`, shared with other workers
+    explicit AnalysisWorker(ResultCallback onResult, ThreadPool& pool = ThreadPool::Shared());
+    ~AnalysisWorker();
+
+    AnalysisWorker(const AnalysisWorker&) = delete;
+    AnalysisWorker& operator=(const AnalysisWorker&) = delete;
+
+    void Submit(AnalysisJob job);
+
+    // The document is at `generation` now; work on older snapshots stops,
+    // and the backlog waits for the next job
+    void Cancel(uint64_t generation);
+
+    // Where the backlog is worked off first, and in what slice size
+    void SetViewport(const TextRange& viewport, size_t sliceBytes);
+
+private:
+    static constexpr std::chrono::milliseconds kResultTime{8};
+
+    void Run();
+
+    ResultCallback m_onResult;
+    DocumentAnalyzer m_analyzer;  // only touched by the worker thread
+    std::atomic<uint64_t> m_latest{0};  // newest generation of the document
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::optional<AnalysisJob> m_pending;
+    TextRange m_viewport;
+    size_t m_sliceBytes = 0;
+    bool m_viewportChanged = false;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+#endif //GROUP56_WORK_ANALYSISWORKER_H
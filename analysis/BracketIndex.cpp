@@ -0,0 +1,426 @@
+#include "BracketIndex.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+const char kOpening[] = "([{";
+const char kClosing[] = ")]}";
+
+// Lines per block when indexing; a block is split once it holds twice that
+const size_t kBlockLines = 256;
+
+int Step(bool open) {
+    return open ? 1 : -1;
+}
+
+} // namespace
+
+void BracketIndex::NoteEdit(size_t line, int linesAdded) {
+    // Nothing to keep aligned until the first Update has indexed the text
+    if (m_blocks.empty()) return;
+
+    // As in DocumentAnalyzer, the text after the edit keeps the line it came
+    // from (and its end state), so new lines go in before it
+    size_t first = std::min(line, LineCount() - 1);
+    auto shift = [&](size_t index) {
+        if (index < first) return index;
+        if (linesAdded >= 0) return index + linesAdded;
+        size_t removed = static_cast<size_t>(-linesAdded);
+        return index < first + removed ? first : index - removed;
+    };
+    if (linesAdded > 0) {
+        size_t index;
+        size_t block = BlockOfLine(first, index);
+        m_blocks[block].insert(m_blocks[block].begin() + index, linesAdded, Line());
+        if (m_blocks[block].size() > 2 * kBlockLines) {
+            SplitBlock(block);
+        } else {
+            UpdateBlock(block);
+        }
+    } else if (linesAdded < 0) {
+        for (size_t left = static_cast<size_t>(-linesAdded); left > 0 && first < LineCount();) {
+            size_t index;
+            size_t block = BlockOfLine(first, index);
+            size_t count = std::min(left, m_blocks[block].size() - index);
+            m_blocks[block].erase(m_blocks[block].begin() + index, m_blocks[block].begin() + index + count);
+            left -= count;
+            if (m_blocks[block].empty()) {
+                m_blocks.erase(m_blocks.begin() + block);
+                Build();
+            } else {
+                UpdateBlock(block);
+            }
+        }
+        if (m_blocks.empty()) return;  // the next Update indexes it all again
+        first = std::min(first, LineCount() - 1);
+    }
+
+    size_t last = first + std::max(linesAdded, 0);
+    if (m_dirty) {
+        m_dirtyFirst = std::min(shift(m_dirtyFirst), first);
+        m_dirtyLast = std::max(shift(m_dirtyLast), last);
+    } else {
+        m_dirtyFirst = first;
+        m_dirtyLast = last;
+        m_dirty = true;
+    }
+    m_dirtyLast = std::min(m_dirtyLast, LineCount() - 1);
+}
+
+void BracketIndex::Update(std::string_view text) {
+    bool changed = false;
+    if (m_blocks.empty()) {
+        LexState state = LexState::Default;
+        size_t pos = 0;
+        do {
+            if (m_blocks.empty() || m_blocks.back().size() == kBlockLines) {
+                m_blocks.emplace_back();
+                m_blocks.back().reserve(kBlockLines);
+            }
+            m_blocks.back().emplace_back();
+            IndexLine(text, pos, m_blocks.back().back(), state);
+            state = m_blocks.back().back().endState;
+            pos += m_blocks.back().back().length;
+        } while (m_blocks.back().back().length > 0 && text[pos - 1] == '\n');
+        Build();
+        m_dirty = false;
+        changed = true;
+    }
+
+    if (m_dirty) {
+        // Lines before the first marked one have their lengths right
+        size_t index;
+        size_t block = BlockOfLine(m_dirtyFirst, index);
+        size_t pos = BlockStart(block);
+        for (size_t i = 0; i < index; ++i) pos += m_blocks[block][i].length;
+        LexState state = index > 0   ? m_blocks[block][index - 1].endState
+                         : block > 0 ? m_blocks[block - 1].back().endState
+                                     : LexState::Default;
+        for (size_t line = m_dirtyFirst; block < m_blocks.size() && pos <= text.size(); ++line) {
+            Line& current = m_blocks[block][index];
+            LexState previous = current.endState;
+            changed |= IndexLine(text, pos, current, state);
+            state = current.endState;
+            pos += current.length;
+            bool done = line >= m_dirtyLast && state == previous;
+            if (done || ++index == m_blocks[block].size()) {
+                UpdateBlock(block);
+                block++;
+                index = 0;
+            }
+            if (done) break;
+        }
+        m_dirty = false;
+    }
+    if (changed) m_version++;
+}
+
+void BracketIndex::Reset() {
+    m_blocks.clear();
+    m_tree.clear();
+    m_leaves = 0;
+    m_dirty = false;
+    m_version++;
+}
+
+// Lexes the line starting at start into `line`; returns whether its brackets changed
+bool BracketIndex::IndexLine(std::string_view text, size_t start, Line& line, LexState state) {
+    size_t end = text.find('\n', start);
+    end = end == std::string_view::npos ? text.size() : end + 1;
+
+    m_tokens.clear();
+    line.endState = LexLine(text, start, end, 0, state, m_tokens);
+    line.length = static_cast<uint32_t>(end - start);
+
+    std::vector<Bracket> brackets;
+    for (const Token& token : m_tokens) {
+        if (token.kind != TokenKind::Punctuation) continue;
+        char c = text[token.offset];
+        const char* open = std::strchr(kOpening, c);
+        const char* close = std::strchr(kClosing, c);
+        if (c == '\0' || (!open && !close)) continue;
+        uint8_t kind = static_cast<uint8_t>(open ? open - kOpening : close - kClosing);
+        brackets.push_back({static_cast<uint32_t>(token.offset - start), kind, open != nullptr});
+    }
+
+    bool same = brackets.size() == line.brackets.size() &&
+                std::equal(brackets.begin(), brackets.end(), line.brackets.begin(),
+                           [](const Bracket& a, const Bracket& b) {
+                               return a.column == b.column && a.kind == b.kind && a.open == b.open;
+                           });
+    line.brackets = std::move(brackets);
+    return !same;
+}
+
+BracketIndex::Node BracketIndex::Summarise(const Block& block) {
+    Node leaf;
+    leaf.lines = block.size();
+    for (const Line& line : block) {
+        leaf.bytes += line.length;
+        for (const Bracket& bracket : line.brackets) {
+            Balance& balance = leaf.balance[bracket.kind];
+            balance.sum += Step(bracket.open);
+            balance.minPrefix = std::min(balance.minPrefix, balance.sum);
+        }
+    }
+    return leaf;
+}
+
+BracketIndex::Node BracketIndex::Combine(const Node& left, const Node& right) {
+    Node node;
+    node.bytes = left.bytes + right.bytes;
+    node.lines = left.lines + right.lines;
+    for (int kind = 0; kind < kKinds; ++kind) {
+        node.balance[kind].sum = left.balance[kind].sum + right.balance[kind].sum;
+        node.balance[kind].minPrefix =
+                std::min(left.balance[kind].minPrefix, left.balance[kind].sum + right.balance[kind].minPrefix);
+    }
+    return node;
+}
+
+void BracketIndex::Build() {
+    m_leaves = 1;
+    while (m_leaves < m_blocks.size()) m_leaves *= 2;
+    m_tree.assign(2 * m_leaves, Node());
+    for (size_t block = 0; block < m_blocks.size(); ++block) m_tree[m_leaves + block] = Summarise(m_blocks[block]);
+    for (size_t i = m_leaves - 1; i > 0; --i) m_tree[i] = Combine(m_tree[2 * i], m_tree[2 * i + 1]);
+}
+
+void BracketIndex::UpdateBlock(size_t block) {
+    size_t node = m_leaves + block;
+    m_tree[node] = Summarise(m_blocks[block]);
+    for (node /= 2; node > 0; node /= 2) m_tree[node] = Combine(m_tree[2 * node], m_tree[2 * node + 1]);
+}
+
+void BracketIndex::SplitBlock(size_t block) {
+    Block& full = m_blocks[block];
+    auto middle = full.begin() + full.size() / 2;
+    Block tail(std::make_move_iterator(middle), std::make_move_iterator(full.end()));
+    full.erase(middle, full.end());
+    m_blocks.insert(m_blocks.begin() + block + 1, std::move(tail));
+    Build();
+}
+
+// Block holding the given line, and the line's index within it
+size_t BracketIndex::BlockOfLine(size_t line, size_t& index) const {
+    size_t node = 1;
+    index = line;
+    while (node < m_leaves) {
+        node *= 2;
+        if (index >= m_tree[node].lines) {
+            index -= m_tree[node].lines;
+            node++;
+        }
+    }
+    return node - m_leaves;
+}
+
+// Block holding the byte at pos, and the block's start
+size_t BracketIndex::BlockOfPos(size_t pos, size_t& blockStart) const {
+    size_t node = 1;
+    blockStart = 0;
+    while (node < m_leaves) {
+        node *= 2;
+        if (pos >= blockStart + m_tree[node].bytes) {
+            blockStart += m_tree[node].bytes;
+            node++;
+        }
+    }
+    return node - m_leaves;
+}
+
+size_t BracketIndex::BlockStart(size_t block) const {
+    size_t start = 0;
+    for (size_t node = m_leaves + block; node > 1; node /= 2) {
+        if (node & 1) start += m_tree[node - 1].bytes;
+    }
+    return start;
+}
+
+const BracketIndex::Bracket* BracketIndex::BracketAt(size_t pos, size_t& block, size_t& index,
+                                                     size_t& lineStart) const {
+    if (m_blocks.empty() || m_dirty || pos >= m_tree[1].bytes) return nullptr;
+    block = BlockOfPos(pos, lineStart);
+    for (index = 0; pos >= lineStart + m_blocks[block][index].length; ++index) {
+        lineStart += m_blocks[block][index].length;
+    }
+    const std::vector<Bracket>& brackets = m_blocks[block][index].brackets;
+    auto it = std::lower_bound(brackets.begin(), brackets.end(), pos - lineStart,
+                               [](const Bracket& bracket, size_t column) { return bracket.column < column; });
+    if (it == brackets.end() || it->column != pos - lineStart) return nullptr;
+    return &*it;
+}
+
+bool BracketIndex::IsBracket(size_t pos) const {
+    size_t block;
+    size_t index;
+    size_t lineStart;
+    return BracketAt(pos, block, index, lineStart) != nullptr;
+}
+
+size_t BracketIndex::Partner(size_t pos) const {
+    size_t block;
+    size_t index;
+    size_t lineStart;
+    const Bracket* bracket = BracketAt(pos, block, index, lineStart);
+    if (!bracket) return npos;
+    int kind = bracket->kind;
+    int balance = 0;
+
+    if (bracket->open) {
+        // Forwards to where the balance after the bracket first goes
+        // negative: through the rest of its block, then the block the tree
+        // finds, then that block's lines
+        const Bracket* from = bracket + 1;
+        for (size_t start = lineStart; index < m_blocks[block].size(); start += m_blocks[block][index++].length) {
+            const std::vector<Bracket>& brackets = m_blocks[block][index].brackets;
+            if (from == nullptr) from = brackets.data();
+            for (const Bracket* it = from; it != brackets.data() + brackets.size(); ++it) {
+                if (it->kind == kind && (balance += Step(it->open)) < 0) return start + it->column;
+            }
+            from = nullptr;
+        }
+        size_t found = FindDrop(1, 0, m_leaves, block + 1, kind, balance);
+        if (found >= m_blocks.size()) return npos;
+        size_t start = BlockStart(found);
+        for (const Line& line : m_blocks[found]) {
+            for (const Bracket& it : line.brackets) {
+                if (it.kind == kind && (balance += Step(it.open)) < 0) return start + it.column;
+            }
+            start += line.length;
+        }
+    } else {
+        // Backwards to where the balance before the bracket first goes positive
+        const Bracket* from = bracket;
+        for (size_t start = lineStart;;) {
+            const std::vector<Bracket>& brackets = m_blocks[block][index].brackets;
+            for (const Bracket* it = from; it != brackets.data();) {
+                --it;
+                if (it->kind == kind && (balance += Step(it->open)) > 0) return start + it->column;
+            }
+            if (index == 0) break;
+            index--;
+            start -= m_blocks[block][index].length;
+            from = m_blocks[block][index].brackets.data() + m_blocks[block][index].brackets.size();
+        }
+        size_t found = FindRise(1, 0, m_leaves, block, kind, balance);
+        if (found >= m_blocks.size()) return npos;
+        size_t end = BlockStart(found) + m_tree[m_leaves + found].bytes;
+        for (auto line = m_blocks[found].rbegin(); line != m_blocks[found].rend(); ++line) {
+            end -= line->length;
+            for (auto it = line->brackets.rbegin(); it != line->brackets.rend(); ++it) {
+                if (it->kind == kind && (balance += Step(it->open)) > 0) return end + it->column;
+            }
+        }
+    }
+    return npos;
+}
+
+// First block at or after `from` within which balance, running over the
+// blocks from there on, goes negative. Adds the blocks skipped to balance.
+size_t BracketIndex::FindDrop(size_t node, size_t lo, size_t hi, size_t from, int kind, int& balance) const {
+    if (hi <= from) return npos;
+    const Balance& here = m_tree[node].balance[kind];
+    if (lo >= from && balance + here.minPrefix >= 0) {
+        balance += here.sum;
+        return npos;
+    }
+    if (hi - lo == 1) return lo;
+    size_t mid = (lo + hi) / 2;
+    size_t found = FindDrop(2 * node, lo, mid, from, kind, balance);
+    return found != npos ? found : FindDrop(2 * node + 1, mid, hi, from, kind, balance);
+}
+
+// Last block before `to` within which balance, running backwards over the
+// blocks from there on, goes positive. Adds the blocks skipped to balance.
+size_t BracketIndex::FindRise(size_t node, size_t lo, size_t hi, size_t to, int kind, int& balance) const {
+    if (lo >= to) return npos;
+    const Balance& here = m_tree[node].balance[kind];
+    if (hi <= to && balance + here.sum - here.minPrefix <= 0) {
+        balance += here.sum;
+        return npos;
+    }
+    if (hi - lo == 1) return lo;
+    size_t mid = (lo + hi) / 2;
+    size_t found = FindRise(2 * node + 1, mid, hi, to, kind, balance);
+    return found != npos ? found : FindRise(2 * node, lo, mid, to, kind, balance);
+}
+
+std::vector<TextRange> BracketIndex::Unmatched() const {
+    std::vector<TextRange> out;
+    if (m_blocks.empty() || m_dirty) return out;
+
+    for (int kind = 0; kind < kKinds; ++kind) {
+        // A closing bracket is unmatched where the balance from the start
+        // reaches a new low, an opening one where the balance from the end
+        // reaches a new high
+        int balance = 0;
+        int lowest = 0;
+        size_t start = 0;
+        CollectClosing(1, 0, m_leaves, kind, balance, lowest, start, out);
+
+        balance = 0;
+        int highest = 0;
+        size_t end = m_tree[1].bytes;
+        CollectOpening(1, 0, m_leaves, kind, balance, highest, end, out);
+    }
+    std::sort(out.begin(), out.end(), [](const TextRange& a, const TextRange& b) { return a.start < b.start; });
+    return out;
+}
+
+void BracketIndex::CollectClosing(size_t node, size_t lo, size_t hi, int kind, int& balance, int& lowest,
+                                  size_t& start, std::vector<TextRange>& out) const {
+    const Balance& here = m_tree[node].balance[kind];
+    if (balance + here.minPrefix >= lowest) {
+        balance += here.sum;
+        start += m_tree[node].bytes;
+        return;
+    }
+    if (hi - lo == 1) {
+        for (const Line& line : m_blocks[lo]) {
+            for (const Bracket& bracket : line.brackets) {
+                if (bracket.kind != kind) continue;
+                balance += Step(bracket.open);
+                if (balance < lowest) {
+                    lowest = balance;
+                    out.push_back({start + bracket.column, start + bracket.column + 1});
+                }
+            }
+            start += line.length;
+        }
+        return;
+    }
+    size_t mid = (lo + hi) / 2;
+    CollectClosing(2 * node, lo, mid, kind, balance, lowest, start, out);
+    CollectClosing(2 * node + 1, mid, hi, kind, balance, lowest, start, out);
+}
+
+void BracketIndex::CollectOpening(size_t node, size_t lo, size_t hi, int kind, int& balance, int& highest,
+                                  size_t& end, std::vector<TextRange>& out) const {
+    const Balance& here = m_tree[node].balance[kind];
+    if (balance + here.sum - here.minPrefix <= highest) {
+        balance += here.sum;
+        end -= m_tree[node].bytes;
+        return;
+    }
+    if (hi - lo == 1) {
+        for (auto line = m_blocks[lo].rbegin(); line != m_blocks[lo].rend(); ++line) {
+            end -= line->length;
+            for (auto it = line->brackets.rbegin(); it != line->brackets.rend(); ++it) {
+                if (it->kind != kind) continue;
+                balance += Step(it->open);
+                if (balance > highest) {
+                    highest = balance;
+                    out.push_back({end + it->column, end + it->column + 1});
+                }
+            }
+        }
+        return;
+    }
+    size_t mid = (lo + hi) / 2;
+    CollectOpening(2 * node + 1, mid, hi, kind, balance, highest, end, out);
+    CollectOpening(2 * node, lo, mid, kind, balance, highest, end, out);
+}
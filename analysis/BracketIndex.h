@@ -0,0 +1,109 @@
+#ifndef GROUP56_WORK_BRACKETINDEX_H
+#define GROUP56_WORK_BRACKETINDEX_H
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "Lexer.h"
+#include "TextRange.h"
+
+// The (), [] and {} of a document that are code, i.e. not inside strings,
+// characters, comments or preprocessor lines, kept up to date across edits.
+//
+// Brackets are found with the same lexer the analysis uses and stored per
+// line. Lines are kept in blocks of a few hundred, and the blocks are the
+// leaves of a segment tree that sums line counts, bytes and, per bracket
+// kind, the balance (opening +1, closing -1) with its lowest prefix. That
+// finds the block holding a bracket, and the block holding its partner, in
+// O(log lines); only those two blocks are scanned. Adding or removing lines
+// only touches one block, unless it has to be split. Like Scintilla's
+// BraceMatch, each kind is balanced on its own.
+//
+// Edits only mark lines; Update relexes them, carrying on past the last
+// marked line while the lexer state at line ends differs from before.
+class BracketIndex {
+public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Keep the lines aligned with the document after an edit. `line` is the
+    // line containing the edit position once the edit is applied.
+    void NoteEdit(size_t line, int linesAdded);
+
+    // Brings the index up to date with text; the first call indexes it all
+    void Update(std::string_view text);
+    void Reset();
+
+    // Changes whenever Update changed any brackets
+    uint64_t Version() const { return m_version; }
+
+    bool IsBracket(size_t pos) const;
+    // Position of the bracket matching the one at pos, or npos if pos isn't
+    // a code bracket or it has no partner
+    size_t Partner(size_t pos) const;
+    // Every bracket without a partner, in document order
+    std::vector<TextRange> Unmatched() const;
+
+private:
+    static constexpr int kKinds = 3;
+
+    struct Bracket {
+        uint32_t column;
+        uint8_t kind;  // index into "([{"
+        bool open;
+    };
+
+    struct Line {
+        uint32_t length = 0;  // including its line end
+        LexState endState = LexState::Default;
+        std::vector<Bracket> brackets;
+    };
+
+    // The highest suffix balance, needed to search backwards, is always
+    // sum - minPrefix
+    struct Balance {
+        int32_t sum = 0;
+        int32_t minPrefix = 0;  // lowest running balance, counting the empty prefix
+    };
+
+    struct Node {
+        uint64_t bytes = 0;
+        size_t lines = 0;
+        Balance balance[kKinds];
+    };
+
+    using Block = std::vector<Line>;
+
+    std::vector<Block> m_blocks;
+    std::vector<Node> m_tree;  // m_tree[1] is the root, block leaves from m_leaves on
+    size_t m_leaves = 0;
+
+    // Lines marked by edits, as [m_dirtyFirst, m_dirtyLast]
+    bool m_dirty = false;
+    size_t m_dirtyFirst = 0;
+    size_t m_dirtyLast = 0;
+
+    uint64_t m_version = 0;
+    std::vector<Token> m_tokens;  // reused while lexing
+
+    bool IndexLine(std::string_view text, size_t start, Line& line, LexState state);
+    static Node Summarise(const Block& block);
+    static Node Combine(const Node& left, const Node& right);
+    void Build();
+    void UpdateBlock(size_t block);
+    void SplitBlock(size_t block);
+
+    size_t LineCount() const { return m_tree.empty() ? 0 : m_tree[1].lines; }
+    size_t BlockOfLine(size_t line, size_t& index) const;
+    size_t BlockOfPos(size_t pos, size_t& blockStart) const;
+    size_t BlockStart(size_t block) const;
+    const Bracket* BracketAt(size_t pos, size_t& block, size_t& index, size_t& lineStart) const;
+
+    size_t FindDrop(size_t node, size_t lo, size_t hi, size_t from, int kind, int& balance) const;
+    size_t FindRise(size_t node, size_t lo, size_t hi, size_t to, int kind, int& balance) const;
+    void CollectClosing(size_t node, size_t lo, size_t hi, int kind, int& balance, int& lowest, size_t& start,
+                        std::vector<TextRange>& out) const;
+    void CollectOpening(size_t node, size_t lo, size_t hi, int kind, int& balance, int& highest, size_t& end,
+                        std::vector<TextRange>& out) const;
+};
+
+#endif //GROUP56_WORK_BRACKETINDEX_H
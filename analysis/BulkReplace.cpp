@@ -0,0 +1,60 @@
+#include "BulkReplace.h"
+
+#include <algorithm>
+#include "SubstringSearcher.h"
+
+namespace {
+
+constexpr size_t kFoldChunkBytes = 1 << 20;
+
+void FoldCase(std::string& bytes) {
+    for (char& c : bytes) {
+        if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+    }
+}
+
+} // namespace
+
+void FindIgnoringCase(std::string_view text, std::string_view needle, std::vector<TextRange>& out) {
+    const size_t n = needle.size();
+    if (n == 0) return;
+    std::string folded(needle);
+    FoldCase(folded);
+    SubstringSearcher searcher(folded);
+
+    // Each chunk runs on n - 1 bytes into the next, for the matches that
+    // start in it and end past it
+    std::string chunk;
+    size_t resume = 0;  // past the last match
+    for (size_t from = 0; from < text.size(); from += kFoldChunkBytes) {
+        chunk.assign(text.substr(from, kFoldChunkBytes + n - 1));
+        FoldCase(chunk);
+        for (size_t hit = searcher.Find(chunk, std::max(resume, from) - from);
+             hit != SubstringSearcher::npos && hit < kFoldChunkBytes; hit = searcher.Find(chunk, hit + n)) {
+            out.push_back({from + hit, from + hit + n});
+            resume = from + hit + n;
+        }
+    }
+}
+
+std::string ReplaceMatches(std::string_view text, const std::vector<TextRange>& matches,
+                           std::string_view replacement) {
+    if (matches.empty()) return std::string();
+
+    const size_t from = matches.front().start;
+    const size_t to = matches.back().end;
+    size_t removed = 0;
+    for (const TextRange& match : matches) removed += match.Length();
+    size_t size = to - from - removed + matches.size() * replacement.size();
+
+    // Written straight into the string, which is sized once
+    std::string result(size, '\0');
+    char* out = &result[0];
+    size_t pos = from;
+    for (const TextRange& match : matches) {
+        out = std::copy(text.data() + pos, text.data() + match.start, out);
+        out = std::copy(replacement.begin(), replacement.end(), out);
+        pos = match.end;
+    }
+    return result;
+}
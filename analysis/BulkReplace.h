@@ -0,0 +1,29 @@
+#ifndef GROUP56_WORK_BULKREPLACE_H
+#define GROUP56_WORK_BULKREPLACE_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TextRange.h"
+
+// Replace all, as one edit.
+//
+// Replacing matches one at a time moves the text after each of them again,
+// so k replacements in n bytes cost O(n·k), and each is an undo step and a
+// modification of its own. Instead the text from the first match to the
+// last is rebuilt once, with its final size worked out beforehand, and goes
+// back into the document as a single replacement.
+
+// Appends the non-overlapping occurrences of `needle` in text, ignoring the
+// case of ASCII letters, as Scintilla's FindText does without
+// SCFIND_MATCHCASE. The text is folded a chunk at a time into a scratch
+// buffer, so folding leaves offsets alone and needs no copy of it all.
+void FindIgnoringCase(std::string_view text, std::string_view needle, std::vector<TextRange>& out);
+
+// text[matches.front().start, matches.back().end) with each match replaced
+// by `replacement`. The matches must be sorted and not overlap; with none,
+// the result is empty.
+std::string ReplaceMatches(std::string_view text, const std::vector<TextRange>& matches,
+                           std::string_view replacement);
+
+#endif //GROUP56_WORK_BULKREPLACE_H
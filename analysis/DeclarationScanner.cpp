@@ -0,0 +1,117 @@
+#include "DeclarationScanner.h"
+
+namespace {
+
+bool IsTypeKeyword(std::string_view word) {
+    return word == "int" || word == "bool" || word == "float" || word == "double" || word == "string";
+}
+
+enum class Expect {
+    Tail,         // after a name: '=', ',' or ';'
+    Initializer,  // at least one token up to ',' or ';'
+    Item,         // a name after ','
+};
+
+} // namespace
+
+std::vector<Declaration> ScanDeclarations(std::string_view text, const std::vector<Token>& tokens,
+                                          size_t first, size_t last) {
+    return ScanDeclarations(text, tokens, first, last, last);
+}
+
+// A match ends at the first ';' after its type, and a failed candidate gives
+// up before it, so nothing carries over a ';' into the next candidate
+std::vector<Declaration> ScanDeclarations(std::string_view text, const std::vector<Token>& tokens,
+                                          size_t first, size_t limit, size_t last) {
+    std::vector<Declaration> declarations;
+
+    // Items after a comma do not depend on where the declaration started, so
+    // once one fails every candidate before that comma fails too
+    size_t skipUntil = first;
+
+    for (size_t i = first; i < limit; ++i) {
+        const Token& type = tokens[i];
+        if (i < skipUntil || type.kind != TokenKind::Identifier || !IsTypeKeyword(TokenText(text, type))) continue;
+
+        // Whitespace, then the first declared name
+        size_t j = i + 1;
+        if (j == last || tokens[j].kind != TokenKind::Identifier || tokens[j].offset == type.End()) continue;
+
+        Expect expect = Expect::Tail;
+        bool haveInitializer = false;
+        size_t lastComma = 0;
+        size_t k = j + 1;
+        bool matched = false;
+        bool failed = false;
+        for (; k < last && !matched && !failed; ++k) {
+            const Token& token = tokens[k];
+            if (token.kind == TokenKind::Comment) continue;
+
+            bool semicolon = IsPunctuation(text, token, ';');
+            bool comma = IsPunctuation(text, token, ',');
+            switch (expect) {
+                case Expect::Initializer:
+                    if (!semicolon && !comma) {
+                        haveInitializer = true;
+                        break;
+                    }
+                    if (!haveInitializer) {
+                        failed = true;
+                        break;
+                    }
+                    // The initializer ended like a tail
+                    [[fallthrough]];
+                case Expect::Tail:
+                    if (semicolon) {
+                        matched = true;
+                    } else if (comma) {
+                        lastComma = k;
+                        expect = Expect::Item;
+                    } else if (IsPunctuation(text, token, '=')) {
+                        haveInitializer = false;
+                        expect = Expect::Initializer;
+                    } else {
+                        failed = true;
+                    }
+                    break;
+                case Expect::Item:
+                    if (token.kind == TokenKind::Identifier) {
+                        expect = Expect::Tail;
+                    } else {
+                        failed = true;
+                    }
+                    break;
+            }
+        }
+
+        if (!matched && !failed) break;  // no ';' left, so nothing later can match either
+        if (failed) {
+            if (lastComma) skipUntil = lastComma;
+            continue;
+        }
+
+        // k is one past the terminating ';'
+        const Token& semicolon = tokens[k - 1];
+        for (size_t n = j; n < k; ++n) {
+            if (tokens[n].kind != TokenKind::Identifier) continue;
+            declarations.push_back({std::string(TokenText(text, tokens[n])), type.offset, semicolon.End(), semicolon.line});
+        }
+        i = k - 1;
+    }
+
+    return declarations;
+}
+
+std::vector<Declaration> ScanDeclarations(std::string_view text) {
+    std::vector<Token> tokens = Tokenize(text);
+    return ScanDeclarations(text, tokens, 0, tokens.size());
+}
+
+void CollectFunctions(std::string_view text, const std::vector<Token>& tokens, size_t limit,
+                      std::vector<TextRange>& out) {
+    for (size_t i = 0; i < limit && i + 1 < tokens.size(); ++i) {
+        if (tokens[i].kind == TokenKind::Identifier && IsPunctuation(text, tokens[i + 1], '(')) {
+            out.push_back({tokens[i].offset, tokens[i].End()});
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef GROUP56_WORK_DECLARATIONSCANNER_H
+#define GROUP56_WORK_DECLARATIONSCANNER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Lexer.h"
+#include "TextRange.h"
+
+// A variable declaration found by ScanDeclarations
+struct Declaration {
+    std::string name;
+    size_t position = 0;  // start of the enclosing declaration statement
+    size_t end = 0;       // just past the statement's terminating ';'
+    uint32_t line = 0;    // line of the terminating ';'
+};
+
+// Finds `bool|int|float|double|string` declarations among tokens[first, last),
+// including comma lists and initializers:
+//   type name [= init] {, name [= init]} ;
+// Every identifier after the type up to the terminating ';' is reported,
+// initializer operands included. Comments are skipped; strings are atomic.
+// A single forward pass over the tokens, with no backtracking. This is the
+// grammar of the std::regex recognizer it replaced, but read over tokens,
+// so unlike that it finds nothing in comments, takes no names from string
+// literals or number suffixes (the f of 1.0f), and wants a token in an
+// initializer: `int x = ;` declares nothing.
+std::vector<Declaration> ScanDeclarations(std::string_view text, const std::vector<Token>& tokens,
+                                          size_t first, size_t last);
+
+// The same for the declarations whose type is in tokens[first, limit), read
+// on up to `last`. Scans of consecutive pieces split right after a ';' find
+// exactly what one scan of the whole finds, so they can run in parallel.
+std::vector<Declaration> ScanDeclarations(std::string_view text, const std::vector<Token>& tokens,
+                                          size_t first, size_t limit, size_t last);
+
+// Tokenizes text and scans all of it
+std::vector<Declaration> ScanDeclarations(std::string_view text);
+
+// Function names (indicator 1): a name directly followed by '('. Only
+// matches starting in tokens[0, limit) are reported; the tokens after that
+// are lookahead past the analysed region.
+void CollectFunctions(std::string_view text, const std::vector<Token>& tokens, size_t limit,
+                      std::vector<TextRange>& out);
+
+#endif //GROUP56_WORK_DECLARATIONSCANNER_H
@@ -0,0 +1,45 @@
+#ifndef GROUP56_WORK_DIRTYRANGE_H
+#define GROUP56_WORK_DIRTYRANGE_H
+
+#include <algorithm>
+#include "TextRange.h"
+
+// Union of all ranges touched by edits since the last analysis, kept in the
+// coordinates of the current document: later edits shift earlier ones.
+class DirtyRange {
+public:
+    void Insert(size_t position, size_t length) {
+        if (!m_set) {
+            m_range = {position, position + length};
+            m_set = true;
+            return;
+        }
+        auto shift = [&](size_t p) { return p >= position ? p + length : p; };
+        m_range.start = std::min(shift(m_range.start), position);
+        m_range.end = std::max(shift(m_range.end), position + length);
+    }
+
+    void Delete(size_t position, size_t length) {
+        if (!m_set) {
+            m_range = {position, position};
+            m_set = true;
+            return;
+        }
+        auto shift = [&](size_t p) {
+            if (p >= position + length) return p - length;
+            return p > position ? position : p;
+        };
+        m_range.start = std::min(shift(m_range.start), position);
+        m_range.end = std::max(shift(m_range.end), position);
+    }
+
+    void Clear() { m_set = false; }
+    bool IsSet() const { return m_set; }
+    TextRange Range() const { return m_range; }
+
+private:
+    TextRange m_range;
+    bool m_set = false;
+};
+
+#endif //GROUP56_WORK_DIRTYRANGE_H
@@ -0,0 +1,690 @@
+#include "DocumentAnalyzer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "ErrorRules.h"
+#include "RangeSet.h"
+
+namespace {
+
+// How far re-analysis is widened looking for the enclosing statement
+const int kMaxStatementLines = 64;
+
+// The highlight cache may hold twice the document's lines, and at least this
+const size_t kMinCachedLines = 4096;
+
+// Passes over more than this are split over the thread pool, in pieces of
+// about this size or more, a few per thread so one slow piece doesn't hold
+// up the rest. Lexing pieces are kept small enough that growing their token
+// buffers never stalls a budget check for long.
+const size_t kMinPieceBytes = 64 << 10;
+const size_t kMaxLexPieceBytes = 1 << 20;
+const size_t kMinPieceTokens = 16 << 10;
+const size_t kPiecesPerThread = 4;
+
+// Lines between budget checks where progress isn't counted in bytes
+const size_t kCheckLines = 256;
+
+const uint64_t kOnes = 0x0101010101010101ULL;
+const uint64_t kHighs = 0x8080808080808080ULL;
+
+// The eight bytes at p, with the newlines among them zero
+uint64_t NewlinesZeroed(const char* p) {
+    uint64_t word;
+    std::memcpy(&word, p, 8);
+    return word ^ (kOnes * '\n');
+}
+
+// Edits deep into a long line make this hot, so it steps back eight bytes
+// at a time until a word holds a newline
+size_t LineStartAt(std::string_view text, size_t pos) {
+    while (pos >= 8) {
+        uint64_t word = NewlinesZeroed(text.data() + pos - 8);
+        if ((word - kOnes) & ~word & kHighs) break;
+        pos -= 8;
+    }
+    while (pos > 0 && text[pos - 1] != '\n') pos--;
+    return pos;
+}
+
+// Position just past the newline ending the line that contains pos
+size_t LineEndAt(std::string_view text, size_t pos) {
+    size_t nl = text.find('\n', pos);
+    return nl == std::string::npos ? text.size() : nl + 1;
+}
+
+// Newlines in text[begin, end), eight bytes at a time: every pass over a
+// long line counts them, and std::count goes a byte at a time
+size_t CountNewlines(std::string_view text, size_t begin, size_t end) {
+    size_t count = 0;
+    const char* p = text.data() + begin;
+    for (; end - begin >= 8; begin += 8, p += 8) {
+        uint64_t word = NewlinesZeroed(p);
+        // High bit of each zero byte, without borrows between bytes
+        uint64_t zeros = ~(((word & ~kHighs) + ~kHighs) | word) & kHighs;
+        count += ((zeros >> 7) * kOnes) >> 56;
+    }
+    for (; begin < end; ++begin, ++p) count += *p == '\n';
+    return count;
+}
+
+// Highlight cache key of the line [pos, stop) starting in `state`. It
+// covers the line and the bytes its patterns can look ahead into, which run
+// to the end of the next line with anything but whitespace on it. Lexing
+// stops kLongLineBytes into a line, so past that only the lengths of the
+// two lines count (error ranges can run to a line end) and are hashed
+// instead of their bytes.
+uint64_t LineKey(std::string_view text, size_t pos, size_t stop, LexState state) {
+    size_t next = stop;
+    while (next < text.size() && (text[next] == ' ' || text[next] == '\t' || text[next] == '\n' ||
+                                  text[next] == '\r' || text[next] == '\v' || text[next] == '\f')) {
+        next++;
+    }
+    size_t end = LineEndAt(text, next);
+    if (stop - pos <= kLongLineBytes && end - next <= kLongLineBytes) {
+        return HighlightCache::Key(text.substr(pos, end - pos), state);
+    }
+
+    const uint64_t mix = 0x9e3779b97f4a7c15ULL;
+    const size_t lengths[] = {stop - pos, end - stop};
+    uint64_t key = HighlightCache::Key(text.substr(pos, std::min(stop - pos, kLongLineBytes)), state);
+    key = key * mix ^ HighlightCache::Key(text.substr(stop, std::min(end, next + kLongLineBytes) - stop), state);
+    return key * mix ^ HighlightCache::Key({reinterpret_cast<const char*>(lengths), sizeof(lengths)}, state);
+}
+
+// Splits range into at most `count` pieces of whole lines. Piece ends are
+// line ends, except that the last piece ends where range does.
+std::vector<TextRange> SplitLines(std::string_view text, const TextRange& range, size_t count) {
+    std::vector<TextRange> pieces;
+    size_t start = range.start;
+    for (size_t i = 1; i <= count && start < range.end; ++i) {
+        size_t target = range.start + range.Length() / count * i;
+        size_t end = i == count ? range.end : std::min(LineEndAt(text, std::max(target, start + 1) - 1), range.end);
+        pieces.push_back({start, end});
+        start = end;
+    }
+    if (pieces.empty()) pieces.push_back(range);
+    return pieces;
+}
+
+} // namespace
+
+DocumentAnalyzer::DocumentAnalyzer(ThreadPool& pool) : m_errorRules(ErrorRules()), m_pool(&pool) {}
+
+void DocumentAnalyzer::ApplyEdit(const EditRecord& edit) {
+    ShiftRanges(m_backlog, edit.position, edit.length, edit.inserted);
+    m_lineIndex.Clear();
+
+    // Nothing to keep aligned until the first full pass has run
+    if (m_lines.empty() || edit.linesAdded == 0) return;
+
+    // The text after the edit keeps the facts of the line it came from (in
+    // particular the lexer state at its end), so new lines go in before it
+    size_t first = std::min(static_cast<size_t>(edit.line), m_lines.size());
+    if (edit.linesAdded > 0) {
+        m_lines.insert(m_lines.begin() + first, edit.linesAdded, LineFacts());
+    } else {
+        size_t last = std::min(first + static_cast<size_t>(-edit.linesAdded), m_lines.size());
+        for (size_t i = first; i < last; ++i) {
+            Touch(m_lines[i]);
+            Forget(m_lines[i]);
+        }
+        m_lines.erase(m_lines.begin() + first, m_lines.begin() + last);
+    }
+}
+
+void DocumentAnalyzer::Reset() {
+    m_backlog.clear();
+    m_lineIndex.Clear();
+    m_lines.clear();
+    m_variableCounts.clear();
+    m_usingNamespaceStd = 0;
+    m_touched.clear();
+    m_analysedNamespaceStd = false;
+}
+
+std::set<std::string> DocumentAnalyzer::Variables() const {
+    std::set<std::string> variables;
+    for (const auto& entry : m_variableCounts) {
+        if (entry.second > 0) variables.insert(entry.first);
+    }
+    return variables;
+}
+
+void DocumentAnalyzer::Touch(const LineFacts& facts) {
+    for (const auto& name : facts.declarations) m_touched.emplace(name, IsDeclared(name));
+}
+
+void DocumentAnalyzer::Forget(const LineFacts& facts) {
+    for (const auto& name : facts.declarations) m_variableCounts[name]--;
+    if (facts.usingNamespaceStd) m_usingNamespaceStd--;
+}
+
+void DocumentAnalyzer::Remember(const LineFacts& facts) {
+    for (const auto& name : facts.declarations) m_variableCounts[name]++;
+    if (facts.usingNamespaceStd) m_usingNamespaceStd++;
+}
+
+bool DocumentAnalyzer::IsDeclared(const std::string& name) const {
+    auto it = m_variableCounts.find(name);
+    return it != m_variableCounts.end() && it->second > 0;
+}
+
+AnalysisResult DocumentAnalyzer::Analyse(std::string_view text, const TextRange& dirty,
+                                         int firstLine, int lineCount, const AnalysisBudget& budget) {
+    AnalysisResult result;
+    m_budget = budget;
+    m_lineIndex.Clear();  // built again if a slice needs it
+
+    // A full pass is needed the first time round, or if the per-line state
+    // somehow drifted from the document
+    result.fullPass = m_lines.size() != static_cast<size_t>(lineCount) ||
+                      firstLine < 0 || firstLine >= lineCount;
+    if (result.fullPass) Reset();
+
+    // Start at the edited line, widened back to just after the previous statement
+    size_t pos = 0;
+    size_t line = 0;
+    if (!result.fullPass) {
+        pos = LineStartAt(text, std::min(dirty.start, text.size()));
+        line = firstLine;
+        for (int i = 0; i < kMaxStatementLines && line > 0 && !m_lines[line - 1].endsStatement; ++i) {
+            pos = LineStartAt(text, pos - 1);
+            line--;
+        }
+    }
+    TextRange region = {pos, pos};
+    size_t regionLine = line;
+    size_t editEnd = std::min(dirty.end, text.size());
+    size_t editLinesEnd = LineEndAt(text, editEnd);
+
+    // Lex line by line. Past the edit, a line's old facts are still valid, so
+    // stop once the lexer state matches the old state again and a ';' has been
+    // seen in unchanged code (a declaration overlapping the edit ended there).
+    // Large full passes are lexed in pieces instead, on one thread or more.
+    std::vector<Token> tokens;
+    std::vector<LineFacts> facts;
+    LexState state = line > 0 ? m_lines[line - 1].endState : LexState::Default;
+    LexState regionState = state;
+    bool terminated = false;
+    int linesPastEdit = 0;
+    bool lexed = false;
+    if (result.fullPass && text.size() >= 2 * kMinPieceBytes) {
+        if (!LexPieces(text, tokens, facts)) return Abandon(result);
+        region.end = text.size();
+        lexed = true;
+    }
+    for (size_t checked = pos; !lexed;) {
+        if (!result.fullPass && line >= m_lines.size()) {
+            Reset();
+            return Analyse(text, {0, text.size()}, 0, lineCount, budget);
+        }
+
+        size_t stop = LineEndAt(text, pos);
+        LexState startState = state;
+        size_t firstToken = tokens.size();
+        facts.push_back(LexLineFacts(text, pos, stop, line, state, tokens));
+        state = facts.back().endState;
+
+        if (!result.fullPass && line > 0 && pos >= editLinesEnd) {
+            linesPastEdit++;
+            if (startState == m_lines[line - 1].endState &&
+                std::any_of(tokens.begin() + firstToken, tokens.end(),
+                            [&](const Token& t) { return IsPunctuation(text, t, ';'); })) {
+                terminated = true;
+            }
+        }
+
+        region.end = stop;
+        bool lastLine = stop == text.size() && (stop == pos || text[stop - 1] != '\n');
+        if (lastLine) break;
+        if (!result.fullPass && stop >= editLinesEnd && state == m_lines[line].endState &&
+            (terminated || linesPastEdit >= kMaxStatementLines)) {
+            break;
+        }
+        pos = stop;
+        line++;
+        if (pos - checked >= AnalysisBudget::kCheckBytes) {
+            if (m_budget.Cancelled()) return Abandon(result);
+            checked = pos;
+        }
+    }
+
+    if (!CollectStatements(text, tokens, regionLine, facts)) return Abandon(result);
+
+    // Nothing is changed before here, so a cancelled pass can just stop. A
+    // full pass starts from nothing and rebuilds everything anyway, so it
+    // has no names to note and can still be given up while counting them.
+    if (result.fullPass) {
+        m_lines = std::move(facts);
+        for (size_t i = 0; i < m_lines.size(); ++i) {
+            if (i % kCheckLines == 0 && m_budget.Cancelled()) return Abandon(result);
+            Remember(m_lines[i]);
+        }
+    } else {
+        // Swap the old facts for the new ones, noting which names appeared or vanished
+        for (size_t i = 0; i < facts.size(); ++i) {
+            LineFacts& current = m_lines[regionLine + i];
+            Touch(current);
+            Touch(facts[i]);
+            Forget(current);
+            current = std::move(facts[i]);
+            Remember(current);
+        }
+    }
+
+    bool variablesChanged = false;
+    for (const auto& entry : m_touched) {
+        if (entry.second != IsDeclared(entry.first)) variablesChanged = true;
+    }
+    m_touched.clear();
+
+    bool namespaceStd = m_usingNamespaceStd > 0;
+    bool errorsChanged = namespaceStd != m_analysedNamespaceStd;
+    m_analysedNamespaceStd = namespaceStd;
+
+    if (result.fullPass || variablesChanged) m_variableMatcher.Build(Variables());
+
+    // Document-wide changes are queued and highlighted in slices, as is a
+    // region too large for one slice
+    if (result.fullPass || variablesChanged || errorsChanged) m_backlog = {{0, text.size()}};
+    if (m_sliceBytes > 0 && region.Length() > m_sliceBytes) {
+        m_backlog.push_back(region);
+        NormalizeRanges(m_backlog);
+        region.end = region.start;
+    }
+    m_backlog = SubtractRanges(m_backlog, {region});
+
+    CollectHighlights(text, region, regionLine, regionState, result);
+
+    return result;
+}
+
+// Gives up on a cancelled pass. A full pass had already thrown away the old
+// facts, so the next one has to start over.
+AnalysisResult DocumentAnalyzer::Abandon(AnalysisResult& result) {
+    if (result.fullPass) Reset();
+    result.cancelled = true;
+    return result;
+}
+
+// Lexes the line text[pos, stop) into tokens and returns its facts, bar
+// the statements ending on it
+DocumentAnalyzer::LineFacts DocumentAnalyzer::LexLineFacts(std::string_view text, size_t pos, size_t stop,
+                                                           size_t line, LexState state, std::vector<Token>& tokens) {
+    size_t firstToken = tokens.size();
+    LineFacts facts;
+    facts.endState = LexLine(text, pos, stop, static_cast<uint32_t>(line), state, tokens);
+    for (size_t i = tokens.size(); i-- > firstToken;) {
+        if (tokens[i].kind == TokenKind::Comment) continue;
+        facts.endsStatement = IsPunctuation(text, tokens[i], ';');
+        break;
+    }
+    return facts;
+}
+
+// Lexes the whole of text in pieces on the pool. Each piece is lexed as if
+// it started in the default state; then, in order, a piece whose previous
+// piece really ends in a comment or continued directive is lexed again from
+// that state until a line ends in the state it ended in the first time, as
+// the rest of the piece is right from there on. False if cancelled.
+bool DocumentAnalyzer::LexPieces(std::string_view text, std::vector<Token>& tokens,
+                                 std::vector<LineFacts>& facts) {
+    size_t count = std::max(m_pool->Size() * kPiecesPerThread, text.size() / kMaxLexPieceBytes);
+    std::vector<TextRange> ranges = SplitLines(text, {0, text.size()}, std::min(count, text.size() / kMinPieceBytes));
+    std::vector<LexPiece> pieces(ranges.size());
+    std::vector<size_t> newlines(ranges.size());
+    m_pool->ParallelFor(ranges.size(), [&](size_t i) {
+        if (m_budget.Cancelled()) return;
+        newlines[i] = CountNewlines(text, ranges[i].start, ranges[i].end);
+    });
+    if (m_budget.Cancelled()) return false;
+    for (size_t i = 0, line = 0; i < ranges.size(); line += newlines[i++]) {
+        pieces[i].range = ranges[i];
+        pieces[i].line = line;
+    }
+
+    m_pool->ParallelFor(pieces.size(), [&](size_t i) {
+        LexPiece& piece = pieces[i];
+        bool lastPiece = piece.range.end == text.size();
+        LexState state = LexState::Default;
+        for (size_t pos = piece.range.start, line = piece.line, checked = pos;; ++line) {
+            if (pos - checked >= AnalysisBudget::kCheckBytes) {
+                if (m_budget.Cancelled()) return;
+                checked = pos;
+            }
+            size_t stop = LineEndAt(text, pos);
+            piece.lineTokens.push_back(piece.tokens.size());
+            piece.facts.push_back(LexLineFacts(text, pos, stop, line, state, piece.tokens));
+            state = piece.facts.back().endState;
+            // The document's last line is empty if it ends in a line break
+            if (stop >= piece.range.end && !(lastPiece && stop > pos && text[stop - 1] == '\n')) break;
+            pos = stop;
+        }
+    });
+    if (m_budget.Cancelled()) return false;
+
+    LexState state = pieces[0].facts.back().endState;
+    for (size_t p = 1; p < pieces.size(); ++p) {
+        LexPiece& piece = pieces[p];
+        if (state != LexState::Default) {
+            std::vector<Token> relexed;
+            size_t i = 0;
+            for (size_t pos = piece.range.start; i < piece.facts.size();) {
+                size_t stop = LineEndAt(text, pos);
+                LexState speculated = piece.facts[i].endState;
+                piece.facts[i] = LexLineFacts(text, pos, stop, piece.line + i, state, relexed);
+                state = piece.facts[i++].endState;
+                pos = stop;
+                if (state == speculated) break;
+            }
+            size_t keep = i < piece.lineTokens.size() ? piece.lineTokens[i] : piece.tokens.size();
+            piece.tokens.erase(piece.tokens.begin(), piece.tokens.begin() + keep);
+            piece.tokens.insert(piece.tokens.begin(), relexed.begin(), relexed.end());
+        }
+        state = piece.facts.back().endState;
+    }
+
+    // Appended a piece at a time rather than copied in parallel, so the
+    // budget is checked between pieces
+    size_t tokenCount = 0;
+    size_t lineCount = 0;
+    for (const auto& piece : pieces) {
+        tokenCount += piece.tokens.size();
+        lineCount += piece.facts.size();
+    }
+    tokens.reserve(tokenCount);
+    facts.reserve(lineCount);
+    for (auto& piece : pieces) {
+        if (m_budget.Cancelled()) return false;
+        tokens.insert(tokens.end(), piece.tokens.begin(), piece.tokens.end());
+        facts.insert(facts.end(), std::make_move_iterator(piece.facts.begin()),
+                     std::make_move_iterator(piece.facts.end()));
+        std::vector<Token>().swap(piece.tokens);
+    }
+    return true;
+}
+
+// Attributes each declaration and `using namespace std;` among tokens to the
+// line holding its terminating ';'. facts[0] is firstLine's. Large token
+// runs are scanned in pieces on the pool, each starting just after a ';' so
+// no statement is cut in two, and each checking the budget before it starts.
+// False if cancelled.
+bool DocumentAnalyzer::CollectStatements(std::string_view text, const std::vector<Token>& tokens,
+                                         size_t firstLine, std::vector<LineFacts>& facts) {
+    size_t count = std::max<size_t>(1, tokens.size() / kMinPieceTokens);
+    std::vector<size_t> starts = {0};
+    for (size_t i = 1; i < count; ++i) {
+        size_t start = std::max(tokens.size() / count * i, starts.back());
+        while (start < tokens.size() && !IsPunctuation(text, tokens[start], ';')) start++;
+        starts.push_back(std::min(start + 1, tokens.size()));
+    }
+    starts.push_back(tokens.size());
+
+    std::vector<std::vector<Declaration>> declarations(count);
+    std::vector<std::vector<uint32_t>> usingLines(count);
+    m_pool->ParallelFor(count, [&](size_t p) {
+        if (m_budget.Cancelled()) return;
+        declarations[p] = ScanDeclarations(text, tokens, starts[p], starts[p + 1], tokens.size());
+        for (size_t i = starts[p]; i < starts[p + 1] && i + 3 < tokens.size(); ++i) {
+            if (IsWord(text, tokens[i], "using") && IsWord(text, tokens[i + 1], "namespace") &&
+                IsWord(text, tokens[i + 2], "std") && IsPunctuation(text, tokens[i + 3], ';')) {
+                usingLines[p].push_back(tokens[i + 3].line);
+            }
+        }
+    });
+    if (m_budget.Cancelled()) return false;
+
+    for (size_t p = 0; p < count; ++p) {
+        if (m_budget.Cancelled()) return false;
+        for (auto& decl : declarations[p]) facts[decl.line - firstLine].declarations.push_back(std::move(decl.name));
+        for (uint32_t line : usingLines[p]) facts[line - firstLine].usingNamespaceStd = true;
+    }
+    return true;
+}
+
+// Highlights of the whole lines in scope, the first of which is `line` and
+// starts in lexer state `state`. Large scopes are split into pieces matched
+// on the pool; a piece starts in the state stored for the line before it.
+// Pieces only read the shared highlight cache, and what they add to their
+// own caches is merged into it afterwards. Whatever the budget leaves
+// undone goes back on the backlog.
+void DocumentAnalyzer::CollectHighlights(std::string_view text, const TextRange& scope, size_t line,
+                                         LexState state, AnalysisResult& result) {
+    result.variableRange = scope;
+    result.functionRange = scope;
+    result.errorRange = scope;
+    if (scope.Empty()) return;
+
+    m_highlightCache.Trim(std::max(2 * m_lines.size(), kMinCachedLines));
+
+    size_t count =
+            m_pool->Size() > 1 ? std::min(m_pool->Size() * kPiecesPerThread, scope.Length() / kMinPieceBytes) : 1;
+    std::vector<TextRange> ranges = SplitLines(text, scope, std::max<size_t>(count, 1));
+    std::vector<HighlightPiece> pieces(ranges.size());
+    std::vector<size_t> newlines(ranges.size());
+    m_pool->ParallelFor(ranges.size(), [&](size_t i) {
+        if (m_budget.Cancelled()) return;
+        newlines[i] = CountNewlines(text, ranges[i].start, ranges[i].end);
+    });
+    for (size_t i = 0, next = line; i < ranges.size(); next += newlines[i++]) {
+        pieces[i].scope = ranges[i];
+        pieces[i].line = next;
+    }
+
+    // Once cancelled, the line counts may be missing
+    if (!m_budget.Cancelled()) {
+        m_pool->ParallelFor(pieces.size(), [&](size_t i) {
+            LexState start = i == 0 ? state : m_lines[pieces[i].line - 1].endState;
+            MatchPiece(text, pieces[i], start);
+        });
+    }
+
+    // The result ends where the first piece to run out of time stopped. The
+    // lines the pieces did cache stay useful, unless the pass is given up
+    // and has to get out of the way quickly.
+    bool cancelled = m_budget.Cancelled();
+    size_t done = scope.start;
+    for (HighlightPiece& piece : pieces) {
+        result.lint.Add(piece.lint);
+        if (cancelled) continue;
+        m_highlightCache.Merge(piece.cache);
+        m_highlightCache.AddLookups(piece.lookups, piece.hits);
+        if (done < piece.scope.start) continue;
+        result.variables.insert(result.variables.end(), piece.variables.begin(), piece.variables.end());
+        result.functions.insert(result.functions.end(), piece.functions.begin(), piece.functions.end());
+        result.errors.insert(result.errors.end(), piece.errors.begin(), piece.errors.end());
+        done = piece.done;
+    }
+    result.cache = m_highlightCache.Stats();
+    result.cancelled = cancelled;
+
+    if (done < scope.end) {
+        m_backlog.push_back({done, scope.end});
+        NormalizeRanges(m_backlog);
+        result.variableRange = result.functionRange = result.errorRange = {scope.start, done};
+    }
+}
+
+// Highlights of one piece. Lines either cache knows are taken from it; the
+// others are lexed and matched in runs of consecutive lines. The piece is
+// worked through in chunks of whole lines, checking the budget before each
+// chunk but the first.
+void DocumentAnalyzer::MatchPiece(std::string_view text, HighlightPiece& piece, LexState state) const {
+    uint32_t context = m_usingNamespaceStd > 0 ? kUsingNamespaceStd : 0;
+    std::vector<PendingLine> pending;
+    std::vector<Token> tokens;
+    size_t line = piece.line;
+    size_t pos = piece.scope.start;
+    while (pos < piece.scope.end) {
+        if (pos > piece.scope.start && m_budget.Exhausted()) break;
+        size_t chunkEnd = std::min(pos + AnalysisBudget::kCheckBytes, piece.scope.end);
+        chunkEnd = std::min(LineEndAt(text, chunkEnd - 1), piece.scope.end);
+
+        // Variables (indicator 0) depend on the declared set, so they aren't
+        // cached. They are matched in runs of lines, leaving out what lexing
+        // leaves out of long lines.
+        size_t variablesFrom = pos;
+        for (; pos < chunkEnd; ++line) {
+            size_t stop = LineEndAt(text, pos);
+            if (stop - pos > kLongLineBytes) {
+                m_variableMatcher.FindAll(text, {variablesFrom, std::min(pos + kLongLineBytes, chunkEnd)},
+                                          piece.variables);
+                variablesFrom = stop;
+            }
+            uint64_t key = LineKey(text, pos, stop, state);
+            const HighlightCache* owner = &m_highlightCache;
+            const HighlightCache::Entry* entry = owner->Find(key);
+            if (!entry) {
+                owner = &piece.cache;
+                entry = owner->Find(key);
+            }
+            piece.lookups++;
+            if (entry) {
+                piece.hits++;
+                HighlightLines(text, pending, tokens, line, state, piece);
+                const HighlightCache::Range* ranges = owner->RangesOf(*entry);
+                for (uint32_t i = 0; i < entry->count; ++i) {
+                    TextRange range = {pos + ranges[i].start, pos + ranges[i].end};
+                    if (ranges[i].rule == HighlightCache::kFunction) {
+                        piece.functions.push_back(range);
+                    } else if (!(m_errorRules.Rules()[ranges[i].rule].skipIf & context)) {
+                        piece.errors.push_back(range);
+                    }
+                }
+                state = entry->endState;
+            } else {
+                state = LexLine(text, pos, stop, static_cast<uint32_t>(line), state, tokens);
+                pending.push_back({pos, stop, key, state});
+            }
+            pos = stop;
+        }
+        m_variableMatcher.FindAll(text, {variablesFrom, chunkEnd}, piece.variables);
+    }
+    HighlightLines(text, pending, tokens, line, state, piece);
+    piece.done = pos;
+}
+
+// Matches the pending lines, whose tokens are in `tokens`, and caches what
+// each of them produced. nextLine and state are where lexing continues.
+void DocumentAnalyzer::HighlightLines(std::string_view text, std::vector<PendingLine>& lines,
+                                      std::vector<Token>& tokens, size_t nextLine, LexState state,
+                                      HighlightPiece& piece) const {
+    if (lines.empty()) return;
+
+    // Function and error patterns may run a couple of tokens past the lines
+    size_t lineTokens = tokens.size();
+    for (size_t pos = lines.back().end; pos < text.size() && tokens.size() < lineTokens + 2; ++nextLine) {
+        size_t stop = LineEndAt(text, pos);
+        state = LexLine(text, pos, stop, static_cast<uint32_t>(nextLine), state, tokens);
+        pos = stop;
+    }
+
+    std::vector<TextRange> functions;
+    std::vector<LintHit> hits;
+    CollectFunctions(text, tokens, lineTokens, functions);
+    m_errorRules.Run(text, tokens, lineTokens, hits, piece.lint);
+
+    // Each match belongs to the line it starts on
+    uint32_t context = m_usingNamespaceStd > 0 ? kUsingNamespaceStd : 0;
+    std::vector<HighlightCache::Range> ranges;
+    size_t f = 0;
+    size_t h = 0;
+    for (const PendingLine& line : lines) {
+        ranges.clear();
+        for (; f < functions.size() && functions[f].start < line.end; ++f) {
+            ranges.push_back({static_cast<uint32_t>(functions[f].start - line.start),
+                              static_cast<uint32_t>(functions[f].end - line.start), HighlightCache::kFunction});
+            piece.functions.push_back(functions[f]);
+        }
+        for (; h < hits.size() && hits[h].range.start < line.end; ++h) {
+            ranges.push_back({static_cast<uint32_t>(hits[h].range.start - line.start),
+                              static_cast<uint32_t>(hits[h].range.end - line.start), hits[h].rule});
+            if (!(m_errorRules.Rules()[hits[h].rule].skipIf & context)) piece.errors.push_back(hits[h].range);
+        }
+        piece.cache.Insert(line.key, line.endState, ranges.data(), ranges.size());
+    }
+    lines.clear();
+    tokens.clear();
+}
+
+void DocumentAnalyzer::Invalidate(size_t textLength) {
+    m_backlog = {{0, textLength}};
+}
+
+void DocumentAnalyzer::SetViewport(const TextRange& viewport, size_t sliceBytes) {
+    m_viewport = viewport;
+    m_sliceBytes = sliceBytes;
+}
+
+TextRange DocumentAnalyzer::PickSlice() const {
+    size_t limit = m_sliceBytes > 0 ? m_sliceBytes : SIZE_MAX;
+
+    // Anything still missing on screen comes first
+    for (const auto& r : m_backlog) {
+        if (!m_viewport.Empty() && r.start < m_viewport.end && r.end > m_viewport.start) {
+            size_t start = std::max(r.start, m_viewport.start);
+            size_t end = std::min(r.end, m_viewport.end);
+            return {start, start + std::min(limit, end - start)};
+        }
+    }
+
+    // Then work outwards from the viewport, closest side first
+    auto after = std::find_if(m_backlog.begin(), m_backlog.end(),
+                              [&](const TextRange& r) { return r.start >= m_viewport.end; });
+    if (after != m_backlog.begin()) {
+        const TextRange& before = *(after - 1);
+        if (after == m_backlog.end() || m_viewport.start - before.end < after->start - m_viewport.end) {
+            return {before.end - std::min(limit, before.Length()), before.end};
+        }
+    }
+    return {after->start, after->start + std::min(limit, after->Length())};
+}
+
+// Line containing pos, from an index built once per snapshot
+size_t DocumentAnalyzer::LineAt(std::string_view text, size_t pos) {
+    if (m_lineIndex.Empty()) m_lineIndex.Build(text);
+    return m_lineIndex.LineOf(pos);
+}
+
+AnalysisResult DocumentAnalyzer::NextSlice(std::string_view text, const AnalysisBudget& budget) {
+    AnalysisResult result;
+    m_budget = budget;
+    if (m_backlog.empty()) return result;
+
+    // Whole lines, so lexing can resume from the stored line states
+    TextRange slice = PickSlice();
+    slice.start = LineStartAt(text, std::min(slice.start, text.size()));
+    slice.end = slice.end > slice.start ? LineEndAt(text, std::min(slice.end, text.size()) - 1) : slice.start;
+    m_backlog = SubtractRanges(m_backlog, {slice});
+    if (slice.Empty()) {
+        m_backlog.clear();  // only positions past the end of the text were left
+        return result;
+    }
+
+    // Widened to statement boundaries like Analyse's regions, so no error
+    // range straddles two slices
+    size_t line = std::min(LineAt(text, slice.start), m_lines.size());
+    for (int i = 0; i < kMaxStatementLines && line > 0 && !m_lines[line - 1].endsStatement; ++i) {
+        slice.start = LineStartAt(text, slice.start - 1);
+        line--;
+    }
+
+    size_t firstLine = line;
+    int extraLines = 0;
+    for (size_t pos = slice.start; pos < text.size(); ++line) {
+        if (pos >= slice.end && (line == 0 || line > m_lines.size() || m_lines[line - 1].endsStatement ||
+                                 ++extraLines > kMaxStatementLines)) {
+            break;
+        }
+        pos = LineEndAt(text, pos);
+        slice.end = std::max(slice.end, pos);
+    }
+    m_backlog = SubtractRanges(m_backlog, {slice});
+
+    LexState state = firstLine > 0 ? m_lines[firstLine - 1].endState : LexState::Default;
+    CollectHighlights(text, slice, firstLine, state, result);
+    return result;
+}
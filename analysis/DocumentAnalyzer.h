@@ -0,0 +1,173 @@
+#ifndef GROUP56_WORK_DOCUMENTANALYZER_H
+#define GROUP56_WORK_DOCUMENTANALYZER_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "AnalysisBudget.h"
+#include "DeclarationScanner.h"
+#include "HighlightCache.h"
+#include "Lexer.h"
+#include "LintEngine.h"
+#include "LineIndex.h"
+#include "TextRange.h"
+#include "ThreadPool.h"
+#include "VariableMatcher.h"
+
+// One insert or delete as reported by wxEVT_STC_MODIFIED
+struct EditRecord {
+    size_t position = 0;
+    size_t length = 0;
+    bool inserted = false;
+    int line = 0;        // line containing position once the edit is applied
+    int linesAdded = 0;  // negative for deletions spanning lines
+};
+
+// Indicator ranges produced by one analysis run. Each *Range member is the
+// span the editor must clear before filling the listed ranges.
+struct AnalysisResult {
+    uint64_t generation = 0;  // edit generation of the text this was computed from
+    bool fullPass = false;
+    bool cancelled = false;   // given up for newer text; nothing below is valid
+    TextRange variableRange;
+    std::vector<TextRange> variables;
+    TextRange functionRange;
+    std::vector<TextRange> functions;
+    TextRange errorRange;
+    std::vector<TextRange> errors;
+    LintStats lint;  // from the error rules run for this result
+    HighlightCacheStats cache;  // as of this result
+};
+
+// Keeps per-line facts about the document so an edit only re-lexes and
+// re-scans the statements it touched. Lexing resumes from the state stored
+// at the end of the previous line and runs until it agrees again with the
+// state stored for the old text. Global rules (declared variable set,
+// `using namespace std;`) are derived from the per-line facts, and a
+// document-wide pass is only made when one of them changes.
+//
+// Large passes are split into pieces of whole lines and run on a thread
+// pool: lexing a whole document, scanning its statements, and matching
+// highlights. See LexPieces and CollectHighlights for how the pieces are
+// stitched back together.
+//
+// Analyse and NextSlice take a budget. Once it is cancelled they stop at
+// the next checkpoint, leaving the analyzer as if the pass never started
+// (the caller must pass the same dirty range again, widened by later
+// edits). Once it runs out of time, only highlighting stops early: the
+// result covers what was done and the rest is queued on the backlog.
+class DocumentAnalyzer {
+public:
+    // Passes are split over `pool`, which must outlive the analyzer
+    explicit DocumentAnalyzer(ThreadPool& pool = ThreadPool::Shared());
+
+    // Keep the per-line state aligned with the document after an edit
+    void ApplyEdit(const EditRecord& edit);
+
+    // Re-analyse the statements around `dirty`. `firstLine` is the line
+    // containing dirty.start and `lineCount` the document's line count.
+    AnalysisResult Analyse(std::string_view text, const TextRange& dirty, int firstLine, int lineCount,
+                           const AnalysisBudget& budget = AnalysisBudget());
+
+    // Forget everything; the next Analyse call makes a full pass
+    void Reset();
+
+    // Highlighting that Analyse can't cover in its own result (document-wide
+    // changes, or a region larger than sliceBytes) is queued as a backlog and
+    // produced by NextSlice in pieces of at most sliceBytes, starting with
+    // the viewport and working outwards. sliceBytes 0 means no limit.
+    void SetViewport(const TextRange& viewport, size_t sliceBytes);
+    bool HasBacklog() const { return !m_backlog.empty(); }
+    AnalysisResult NextSlice(std::string_view text, const AnalysisBudget& budget = AnalysisBudget());
+
+    // Queue the whole document for re-highlighting, e.g. after a result was
+    // dropped before it reached the screen
+    void Invalidate(size_t textLength);
+
+    std::set<std::string> Variables() const;
+
+private:
+    struct LineFacts {
+        std::vector<std::string> declarations;  // terminated on this line
+        bool usingNamespaceStd = false;
+        bool endsStatement = false;             // last code token is ';'
+        LexState endState = LexState::Default;
+    };
+
+    std::vector<LineFacts> m_lines;
+    std::map<std::string, int> m_variableCounts;
+    int m_usingNamespaceStd = 0;
+    VariableMatcher m_variableMatcher;  // rebuilt when the declared set changes
+    LintEngine m_errorRules;
+    HighlightCache m_highlightCache;    // function and error highlights of unchanged lines
+
+    // What the last result was based on, to tell when a global rule changed.
+    // m_touched maps names whose count changed since then to whether they
+    // were declared at the time.
+    std::map<std::string, bool> m_touched;
+    bool m_analysedNamespaceStd = false;
+
+    // Ranges whose highlights are still out of date, and where to start on them
+    std::vector<TextRange> m_backlog;
+    TextRange m_viewport;
+    size_t m_sliceBytes = 0;
+    LineIndex m_lineIndex;  // of the current snapshot, for LineAt
+    ThreadPool* m_pool;
+    AnalysisBudget m_budget;  // of the pass under way
+
+    // A piece of the document lexed on its own for a full pass, assuming it
+    // starts in the default lexer state until LexPieces knows better
+    struct LexPiece {
+        TextRange range;
+        size_t line = 0;  // of range.start
+        std::vector<Token> tokens;
+        std::vector<LineFacts> facts;
+        std::vector<size_t> lineTokens;  // index of each line's first token
+    };
+
+    // A piece of a CollectHighlights scope, matched on its own
+    struct HighlightPiece {
+        TextRange scope;
+        size_t line = 0;  // of scope.start
+        std::vector<TextRange> variables;
+        std::vector<TextRange> functions;
+        std::vector<TextRange> errors;
+        LintStats lint;
+        HighlightCache cache;  // the lines the shared cache didn't have
+        uint64_t lookups = 0;
+        uint64_t hits = 0;
+        size_t done = 0;  // highlights are complete up to here
+    };
+
+    // A line the highlight cache didn't have, lexed into the pending tokens
+    struct PendingLine {
+        size_t start;
+        size_t end;
+        uint64_t key;
+        LexState endState;
+    };
+
+    AnalysisResult Abandon(AnalysisResult& result);
+    static LineFacts LexLineFacts(std::string_view text, size_t pos, size_t stop, size_t line, LexState state,
+                                  std::vector<Token>& tokens);
+    bool LexPieces(std::string_view text, std::vector<Token>& tokens, std::vector<LineFacts>& facts);
+    bool CollectStatements(std::string_view text, const std::vector<Token>& tokens, size_t firstLine,
+                           std::vector<LineFacts>& facts);
+    void CollectHighlights(std::string_view text, const TextRange& scope, size_t line, LexState state,
+                           AnalysisResult& result);
+    void MatchPiece(std::string_view text, HighlightPiece& piece, LexState state) const;
+    void HighlightLines(std::string_view text, std::vector<PendingLine>& lines, std::vector<Token>& tokens,
+                        size_t nextLine, LexState state, HighlightPiece& piece) const;
+    TextRange PickSlice() const;
+    size_t LineAt(std::string_view text, size_t pos);
+
+    void Touch(const LineFacts& facts);
+    void Forget(const LineFacts& facts);
+    void Remember(const LineFacts& facts);
+    bool IsDeclared(const std::string& name) const;
+};
+
+#endif //GROUP56_WORK_DOCUMENTANALYZER_H
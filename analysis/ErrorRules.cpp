@@ -0,0 +1,28 @@
+#include "ErrorRules.h"
+
+std::vector<LintRule> ErrorRules() {
+    return {
+            // A type keyword or `return` with no ';', '{' or '}' after it on its line
+            {"missing semicolon",
+             {{LintMatch::Word, "return int float double bool string"},
+              {LintMatch::NotPunct, ";{}", LintSpacing::SameLine, true},
+              {LintMatch::LineEnd}},
+             LintExtent::ThroughLineEnd},
+            // A string literal that runs off its line
+            {"unbalanced quote",
+             {{LintMatch::UnterminatedString}},
+             LintExtent::FirstByte},
+            // `cout >>` (should be <<)
+            {"cout >>",
+             {{LintMatch::Word, "cout"}, {LintMatch::Punct, ">"}, {LintMatch::Punct, ">", LintSpacing::Glued}}},
+            // `return 0` ending its line without a semicolon
+            {"return 0 without semicolon",
+             {{LintMatch::Word, "return"}, {LintMatch::Number, "0", LintSpacing::Spaced}, {LintMatch::LineEnd}},
+             LintExtent::ThroughLineEnd},
+            // `std::` while `using namespace std;` is missing
+            {"std:: without using namespace std",
+             {{LintMatch::Word, "std"}, {LintMatch::Punct, ":", LintSpacing::Glued},
+              {LintMatch::Punct, ":", LintSpacing::Glued}},
+             LintExtent::Tokens, kUsingNamespaceStd},
+    };
+}
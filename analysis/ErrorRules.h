@@ -0,0 +1,14 @@
+#ifndef GROUP56_WORK_ERRORRULES_H
+#define GROUP56_WORK_ERRORRULES_H
+
+#include <cstdint>
+#include <vector>
+#include "LintEngine.h"
+
+// Context flags for the error rules
+const uint32_t kUsingNamespaceStd = 1;
+
+// The checks behind the error underlines (indicator 4)
+std::vector<LintRule> ErrorRules();
+
+#endif //GROUP56_WORK_ERRORRULES_H
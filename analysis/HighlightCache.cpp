@@ -0,0 +1,71 @@
+#include "HighlightCache.h"
+
+#include <cstring>
+
+uint64_t HighlightCache::Key(std::string_view bytes, LexState state) {
+    // MurmurHash64A, seeded with the lexer state
+    const uint64_t m = 0xc6a4a7935bd1e995ULL;
+    const int r = 47;
+    uint64_t h = (static_cast<uint64_t>(state) + 1) ^ (bytes.size() * m);
+
+    const char* p = bytes.data();
+    size_t blocks = bytes.size() / 8;
+    for (size_t i = 0; i < blocks; ++i, p += 8) {
+        uint64_t k;
+        std::memcpy(&k, p, 8);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    size_t tail = bytes.size() & 7;
+    if (tail) {
+        uint64_t k = 0;
+        for (size_t i = 0; i < tail; ++i) k |= static_cast<uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+        h ^= k;
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+const HighlightCache::Entry* HighlightCache::Find(uint64_t key) const {
+    auto it = m_entries.find(key);
+    return it == m_entries.end() ? nullptr : &it->second;
+}
+
+void HighlightCache::Insert(uint64_t key, LexState endState, const Range* ranges, size_t count) {
+    Entry entry;
+    entry.first = static_cast<uint32_t>(m_ranges.size());
+    entry.count = static_cast<uint32_t>(count);
+    entry.endState = endState;
+    if (m_entries.emplace(key, entry).second) m_ranges.insert(m_ranges.end(), ranges, ranges + count);
+}
+
+void HighlightCache::Merge(const HighlightCache& other) {
+    for (const auto& entry : other.m_entries) {
+        Insert(entry.first, entry.second.endState, other.RangesOf(entry.second), entry.second.count);
+    }
+}
+
+void HighlightCache::Clear() {
+    m_entries.clear();
+    m_ranges.clear();
+}
+
+HighlightCacheStats HighlightCache::Stats() const {
+    HighlightCacheStats stats;
+    stats.lookups = m_lookups;
+    stats.hits = m_hits;
+    stats.entries = m_entries.size();
+    // A node per entry (the pair plus a next pointer and its cached hash),
+    // the bucket array and the range pool
+    stats.bytes = m_entries.size() * (sizeof(std::pair<const uint64_t, Entry>) + 2 * sizeof(void*)) +
+                  m_entries.bucket_count() * sizeof(void*) + m_ranges.capacity() * sizeof(Range);
+    return stats;
+}
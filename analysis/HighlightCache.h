@@ -0,0 +1,74 @@
+#ifndef GROUP56_WORK_HIGHLIGHTCACHE_H
+#define GROUP56_WORK_HIGHLIGHTCACHE_H
+
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Lexer.h"
+
+// How well the HighlightCache is doing
+struct HighlightCacheStats {
+    uint64_t lookups = 0;
+    uint64_t hits = 0;
+    size_t entries = 0;
+    size_t bytes = 0;  // estimated heap footprint
+};
+
+// Function and error highlights of single lines, so lines that didn't
+// change are neither lexed nor matched again when a document-wide change
+// (a new variable, `using namespace std;` toggled) repaints everything.
+//
+// A line's key hashes the lexer state it starts in, its bytes, and the
+// bytes its patterns can look ahead into, which run to the end of the next
+// line that isn't blank. The entry keeps the state the line ends in, so
+// lookups for the following lines chain without lexing, and its ranges
+// relative to the line start. Once the cache outgrows its capacity it is
+// emptied by the next Trim and refills from the lines in use.
+class HighlightCache {
+public:
+    static constexpr uint8_t kFunction = 0xFF;
+
+    struct Range {
+        uint32_t start;
+        uint32_t end;
+        uint8_t rule;  // index of the error rule, or kFunction
+    };
+
+    struct Entry {
+        uint32_t first = 0;  // into the range pool
+        uint32_t count = 0;
+        LexState endState = LexState::Default;
+    };
+
+    static uint64_t Key(std::string_view bytes, LexState state);
+
+    // The entry for key, or nullptr. Entries stay put until Trim or Clear;
+    // their ranges only until the next Insert. Lookups don't modify the
+    // cache, so several threads may look up at once while nobody inserts;
+    // they count them themselves and report them with AddLookups.
+    const Entry* Find(uint64_t key) const;
+    const Range* RangesOf(const Entry& entry) const { return m_ranges.data() + entry.first; }
+    void Insert(uint64_t key, LexState endState, const Range* ranges, size_t count);
+    void AddLookups(uint64_t lookups, uint64_t hits) {
+        m_lookups += lookups;
+        m_hits += hits;
+    }
+    // Inserts every entry of other
+    void Merge(const HighlightCache& other);
+
+    // Empties the cache if it holds more than `capacity` entries
+    void Trim(size_t capacity) {
+        if (m_entries.size() > capacity) Clear();
+    }
+    void Clear();
+    HighlightCacheStats Stats() const;
+
+private:
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::vector<Range> m_ranges;
+    uint64_t m_lookups = 0;
+    uint64_t m_hits = 0;
+};
+
+#endif //GROUP56_WORK_HIGHLIGHTCACHE_H
@@ -0,0 +1,250 @@
+#include "IncrementalFind.h"
+
+#include <algorithm>
+
+namespace {
+
+constexpr size_t kPrefetchAhead = 16;  // candidates
+
+inline void Prefetch(const char* p) {
+#ifdef __GNUC__
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// Whether two occurrences of `query` can overlap: some proper prefix of it
+// is also a suffix (the KMP failure value of the whole query is non-zero)
+bool SelfOverlaps(const std::string& query) {
+    std::vector<size_t> border(query.size(), 0);
+    for (size_t i = 1; i < query.size(); ++i) {
+        size_t k = border[i - 1];
+        while (k > 0 && query[i] != query[k]) k = border[k - 1];
+        border[i] = query[i] == query[k] ? k + 1 : 0;
+    }
+    return !query.empty() && border.back() > 0;
+}
+
+} // namespace
+
+void IncrementalFind::SetQuery(std::string_view text, std::string query, bool regex, const TextRange& viewport) {
+    bool extends = !regex && !m_regex && !m_selfOverlaps && !m_query.empty() && m_textSize == text.size() &&
+                   query.size() > m_query.size() && query.compare(0, m_query.size(), m_query) == 0;
+
+    m_query = std::move(query);
+    m_regex = regex;
+    m_error.clear();
+    if (!regex) {
+        m_searcher = SubstringSearcher(m_query);
+        m_selfOverlaps = SelfOverlaps(m_query);
+    }
+    if (extends) {
+        Narrow(viewport);
+        Step(text, viewport.Length());
+        return;
+    }
+
+    m_candidates.clear();
+    m_matches.clear();
+    m_textSize = text.size();
+    m_origin = std::min(viewport.start, text.size());
+    m_next = m_origin;
+    m_wrapped = false;
+    m_wrapIndex = kNotYet;
+    m_done = m_query.empty();
+    if (regex && !m_done && !m_regexSearcher.Compile(m_query)) {
+        m_error = m_regexSearcher.Error();
+        m_done = true;
+    }
+    if (!m_done) Step(text, viewport.Length());
+}
+
+void IncrementalFind::Reset() {
+    m_query.clear();
+    m_error.clear();
+    m_matches.clear();
+    m_candidates.clear();
+    m_done = true;
+}
+
+bool IncrementalFind::Step(std::string_view text, size_t bytes) {
+    if (m_done) return false;
+    if (!m_candidates.empty()) {
+        Recheck(text, bytes);
+        return !m_done;
+    }
+
+    const size_t runEnd = RunEnd();
+    const size_t from = m_next;
+    size_t stop = runEnd - from <= bytes ? runEnd : from + bytes;
+    if (m_regex) {
+        // A match may run on past the slice end, so only the matches the rest
+        // of the text can't change are kept. Where an attempt at one is still
+        // going from the slice start, the slice grows until it isn't.
+        size_t settled = stop;
+        while (stop > from && stop < m_textSize) {
+            settled = m_regexSearcher.Unsettled(text, {from, stop});
+            if (settled > from) break;
+            stop = std::min(m_textSize, from + 2 * (stop - from));
+            settled = stop;
+        }
+        settled = std::min(settled, runEnd);
+        size_t found = m_matches.size();
+        m_regexSearcher.FindAll(text, {from, stop}, m_matches);
+        while (m_matches.size() > found && m_matches.back().start >= settled) m_matches.pop_back();
+        m_next = m_matches.size() > found ? std::max(settled, m_matches.back().end) : settled;
+    } else {
+        // Matches starting before stop, which may run on past it
+        const size_t n = m_query.size();
+        std::string_view view = text.substr(0, std::min(text.size(), stop + n - 1));
+        for (size_t hit = m_searcher.Find(view, from); hit != SubstringSearcher::npos;
+             hit = m_searcher.Find(view, hit + n)) {
+            m_matches.push_back({hit, hit + n});
+            m_next = hit + n;
+        }
+        m_next = std::max(m_next, stop);
+    }
+    EndRun(text);
+    return !m_done;
+}
+
+// Once the search reaches the end of the text it wraps round to the top,
+// and once it reaches the origin after that it is done
+void IncrementalFind::EndRun(std::string_view text) {
+    if (m_next < RunEnd()) return;
+    if (!m_wrapped) {
+        m_wrapped = true;
+        m_wrapIndex = m_matches.size();
+        m_next = 0;
+        if (m_origin > 0) return;
+    }
+    Finish(text);
+}
+
+// Sets the matches so far up to be re-checked for the extended query. Once
+// they are all found, they are re-checked from the new viewport on.
+void IncrementalFind::Narrow(const TextRange& viewport) {
+    if (m_candidates.empty()) {
+        m_candidateWrap = FirstRunEnd();
+    } else {
+        // Still re-checking for the previous query: what it hadn't got to
+        // goes after what it kept, in each run
+        size_t wrap = m_candidateNext <= m_candidateWrap ? m_matches.size() + (m_candidateWrap - m_candidateNext)
+                                                         : m_wrapIndex;
+        for (size_t i = m_candidateNext; i < m_candidates.size(); ++i) m_matches.push_back(Candidate(i));
+        m_candidateWrap = wrap;
+    }
+    m_candidates.swap(m_matches);
+    m_matches.clear();
+    m_candidateShift = 0;
+    m_candidateNext = 0;
+    m_lastEnd = 0;
+    m_wrapIndex = kNotYet;
+    if (m_done) {
+        // In document order; read from the new origin round to it
+        m_origin = std::min(viewport.start, m_textSize);
+        auto split = std::lower_bound(m_candidates.begin(), m_candidates.end(), m_origin,
+                                      [](const TextRange& match, size_t pos) { return match.start < pos; });
+        m_candidateShift = split - m_candidates.begin();
+        m_candidateWrap = m_candidates.size() - m_candidateShift;
+        m_wrapped = true;
+        m_next = m_origin;
+        m_done = false;
+    }
+    // With none to re-check, the search just goes on in the run it is in
+    if (m_candidates.empty() && m_wrapped) m_wrapIndex = 0;
+}
+
+// Keeps the previous matches the query still has, each run of them (from
+// the origin on and before it) kept non-overlapping on its own; the matches
+// in a run are followed by any the search then finds in it
+void IncrementalFind::Recheck(std::string_view text, size_t bytes) {
+    const size_t n = m_query.size();
+    size_t i = m_candidateNext;
+    if (i == m_candidateWrap) {
+        m_wrapIndex = m_matches.size();
+        m_lastEnd = 0;
+    }
+    const size_t runEnd = i < m_candidateWrap ? m_candidateWrap : m_candidates.size();
+    const size_t limit = Candidate(i).start + bytes;
+    for (; i < runEnd && Candidate(i).start < limit; ++i) {
+        size_t start = Candidate(i).start;
+        // The candidates are far apart in a text far bigger than the cache
+        if (i + kPrefetchAhead < runEnd) Prefetch(text.data() + Candidate(i + kPrefetchAhead).start);
+        if (start < m_lastEnd || start + n > text.size() || text.compare(start, n, m_query) != 0) continue;
+        m_matches.push_back({start, start + n});
+        m_lastEnd = start + n;
+    }
+    m_candidateNext = i;
+    if (i < m_candidates.size()) return;
+
+    // On to the text that wasn't searched for the previous query
+    if (m_wrapped && m_candidateWrap == m_candidates.size()) {
+        m_wrapIndex = m_matches.size();
+        m_lastEnd = 0;
+    }
+    m_candidates.clear();
+    m_next = std::max(m_next, m_lastEnd);
+    EndRun(text);
+}
+
+void IncrementalFind::Finish(std::string_view text) {
+    m_done = true;
+    std::rotate(m_matches.begin(), m_matches.begin() + m_wrapIndex, m_matches.end());
+    size_t seam = m_matches.size() - m_wrapIndex;  // the first match from the viewport on
+    if (seam == 0 || seam == m_matches.size() || m_matches[seam - 1].end <= m_matches[seam].start) return;
+
+    // The text from the viewport on was searched as if nothing came before
+    // it, but a match before runs into it. Redo the matches after that one
+    // until they fall back in step with the ones already found.
+    std::vector<TextRange> redone;
+    size_t resync = seam;
+    if (m_regex) {
+        // In step once the matches redone up to one already found are settled
+        size_t from = m_matches[seam - 1].end;
+        size_t reach = from;
+        for (;;) {
+            while (resync < m_matches.size() && m_matches[resync].start < reach) resync++;
+            size_t stop = resync < m_matches.size() ? m_matches[resync].start : text.size();
+            if (stop == from) break;
+            size_t settled = stop == text.size() ? stop : m_regexSearcher.Unsettled(text, {from, stop});
+            size_t found = redone.size();
+            m_regexSearcher.FindAll(text, {from, stop}, redone);
+            while (redone.size() > found && redone.back().start >= settled) redone.pop_back();
+            if (settled == stop) break;
+            size_t next = redone.size() > found ? std::max(settled, redone.back().end) : settled;
+            // Not settled from `from` on: look twice as far
+            reach = next > from ? next : from + 2 * (stop - from);
+            from = next;
+        }
+    } else {
+        const size_t n = m_query.size();
+        bool inStep = false;
+        for (size_t hit = m_searcher.Find(text, m_matches[seam - 1].end); hit != SubstringSearcher::npos;
+             hit = m_searcher.Find(text, hit + n)) {
+            while (resync < m_matches.size() && m_matches[resync].start < hit) resync++;
+            if (resync < m_matches.size() && m_matches[resync].start == hit) {
+                inStep = true;
+                break;
+            }
+            redone.push_back({hit, hit + n});
+        }
+        if (!inStep) resync = m_matches.size();
+    }
+    m_matches.erase(m_matches.begin() + seam, m_matches.begin() + resync);
+    m_matches.insert(m_matches.begin() + seam, redone.begin(), redone.end());
+}
+
+size_t IncrementalFind::CountBefore(size_t pos) const {
+    auto startsBefore = [](const TextRange& match, size_t p) { return match.start < p; };
+    auto split = m_matches.begin() + FirstRunEnd();
+    return (std::lower_bound(m_matches.begin(), split, pos, startsBefore) - m_matches.begin()) +
+           (std::lower_bound(split, m_matches.end(), pos, startsBefore) - split);
+}
+
+TextRange IncrementalFind::NextMatch(size_t pos) const {
+    if (m_matches.empty()) return TextRange();
+    size_t next = CountBefore(pos);
+    return MatchAt(next < m_matches.size() ? next : 0);
+}
@@ -0,0 +1,106 @@
+#ifndef GROUP56_WORK_INCREMENTALFIND_H
+#define GROUP56_WORK_INCREMENTALFIND_H
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "RegexSearcher.h"
+#include "SubstringSearcher.h"
+#include "TextRange.h"
+
+// Search-as-you-type over one document, a slice at a time.
+//
+// A query is searched from the start of the viewport to the end of the text
+// and then from the top back round to the viewport, so what is on screen is
+// found first and the rest can be left to idle time. Matches don't overlap,
+// as with SubstringSearcher::FindBatch and RegexSearcher::FindAll.
+//
+// A literal query that extends the previous one only re-checks that one's
+// matches, as far as they have been found and again viewport first, instead
+// of searching that part of the text again: every occurrence of the longer
+// query is an occurrence of the shorter. The non-overlapping matches are
+// all the occurrences only if the shorter query can't overlap itself, i.e.
+// no proper prefix of it is also a suffix, so a query like "abab" is
+// followed by a fresh search.
+//
+// A regular expression match can run on past where a slice ends, so a slice
+// keeps only the matches starting before the earliest attempt at one still
+// going there (RegexSearcher::Unsettled) and the next resumes after them.
+// The results are those of one FindAll over the whole text.
+class IncrementalFind {
+public:
+    // Starts searching `text` for `query` and searches `viewport` straight
+    // away. The text must be the one the previous query was searched in
+    // unless Reset was called since.
+    void SetQuery(std::string_view text, std::string query, bool regex, const TextRange& viewport);
+
+    // Drops the query and its matches, e.g. because the text changed
+    void Reset();
+
+    // Searches about `bytes` more of the text; false once all of it is done
+    bool Step(std::string_view text, size_t bytes);
+    bool Done() const { return m_done; }
+
+    const std::string& Query() const { return m_query; }
+    // Why the regular expression couldn't be used, if it couldn't
+    const std::string& Error() const { return m_error; }
+
+    // The matches found so far, numbered in document order. Numbers shift
+    // while the search goes on, as matches are found before others.
+    size_t Count() const { return m_matches.size(); }
+    TextRange MatchAt(size_t i) const {
+        size_t before = m_matches.size() - FirstRunEnd();  // found before the viewport
+        return i < before ? m_matches[FirstRunEnd() + i] : m_matches[i - before];
+    }
+    // How many of them start before pos, i.e. the number of the first one
+    // at or after it
+    size_t CountBefore(size_t pos) const;
+
+    // The first match found so far that starts at or after pos, else the
+    // first in the document, or an empty range if there are none
+    TextRange NextMatch(size_t pos) const;
+
+private:
+    static constexpr size_t kNotYet = static_cast<size_t>(-1);
+
+    // Where the matches before the viewport begin in m_matches; they come
+    // after the rest until the search is done
+    size_t FirstRunEnd() const { return m_done ? m_matches.size() : std::min(m_wrapIndex, m_matches.size()); }
+    size_t RunEnd() const { return m_wrapped ? m_origin : m_textSize; }
+    const TextRange& Candidate(size_t i) const {
+        size_t at = i + m_candidateShift;
+        return m_candidates[at < m_candidates.size() ? at : at - m_candidates.size()];
+    }
+
+    void Narrow(const TextRange& viewport);
+    void Recheck(std::string_view text, size_t bytes);
+    void EndRun(std::string_view text);
+    void Finish(std::string_view text);
+
+    std::string m_query;
+    bool m_regex = false;
+    bool m_selfOverlaps = false;  // the literal query can overlap itself
+    std::string m_error;
+    SubstringSearcher m_searcher{std::string()};
+    RegexSearcher m_regexSearcher;
+
+    std::vector<TextRange> m_matches;
+    size_t m_textSize = 0;
+    size_t m_origin = 0;     // the viewport start, where searching began
+    size_t m_next = 0;       // where searching resumes
+    bool m_wrapped = false;  // on to the text before m_origin
+    size_t m_wrapIndex = kNotYet;  // once the search has got to the text before m_origin
+    bool m_done = true;
+
+    // The previous query's matches, left to re-check: those from m_origin
+    // on, then from m_candidateWrap, those before it. They are read from
+    // m_candidateShift on, round to the start.
+    std::vector<TextRange> m_candidates;
+    size_t m_candidateShift = 0;
+    size_t m_candidateWrap = 0;
+    size_t m_candidateNext = 0;
+    size_t m_lastEnd = 0;  // of the last match kept from them
+};
+
+#endif //GROUP56_WORK_INCREMENTALFIND_H
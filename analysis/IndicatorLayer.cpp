@@ -0,0 +1,100 @@
+#include "IndicatorLayer.h"
+
+#include <algorithm>
+#include "RangeSet.h"
+
+namespace {
+
+// First applied range that ends after pos
+std::vector<TextRange>::iterator FirstEndingAfter(std::vector<TextRange>& ranges, size_t pos) {
+    return std::upper_bound(ranges.begin(), ranges.end(), pos,
+                            [](size_t p, const TextRange& r) { return p < r.end; });
+}
+
+} // namespace
+
+void IndicatorLayer::NoteInsert(size_t position, size_t length) {
+    // Inserted text takes the indicator of the character before it
+    for (auto it = FirstEndingAfter(m_applied, position > 0 ? position - 1 : 0); it != m_applied.end(); ++it) {
+        if (it->start >= position) it->start += length;
+        it->end += length;
+    }
+    m_unknown.Insert(position, length);
+}
+
+void IndicatorLayer::NoteDelete(size_t position, size_t length) {
+    auto shift = [&](size_t p) {
+        if (p >= position + length) return p - length;
+        return p > position ? position : p;
+    };
+    auto first = FirstEndingAfter(m_applied, position);
+    for (auto it = first; it != m_applied.end(); ++it) {
+        it->start = shift(it->start);
+        it->end = shift(it->end);
+    }
+    // Ranges inside the deleted text collapsed to empty ones at `position`,
+    // and the ones on either side may now touch
+    auto stop = std::find_if(first, m_applied.end(), [&](const TextRange& r) { return r.start > position; });
+    if (stop != m_applied.end()) ++stop;
+    if (first != m_applied.begin()) --first;
+    std::vector<TextRange> affected(first, stop);
+    NormalizeRanges(affected);
+    size_t index = first - m_applied.begin();
+    m_applied.erase(first, stop);
+    m_applied.insert(m_applied.begin() + index, affected.begin(), affected.end());
+    m_unknown.Delete(position, length);
+}
+
+void IndicatorLayer::Reset() {
+    m_applied.clear();
+    m_unknown.Clear();
+}
+
+IndicatorDelta IndicatorLayer::Update(const TextRange& scope, std::vector<TextRange> ranges) {
+    m_stats.rangesRequested += ranges.size();
+
+    for (auto& r : ranges) {
+        r.start = std::max(r.start, scope.start);
+        r.end = std::min(r.end, scope.end);
+    }
+    NormalizeRanges(ranges);
+
+    // What is on screen inside scope, split into what we are sure of and what may be set
+    auto first = FirstEndingAfter(m_applied, scope.start);
+    auto last = first;
+    std::vector<TextRange> old;
+    for (; last != m_applied.end() && last->start < scope.end; ++last) {
+        old.push_back({std::max(last->start, scope.start), std::min(last->end, scope.end)});
+    }
+    std::vector<TextRange> maybe = old;
+    if (m_unknown.IsSet()) {
+        TextRange unknown = m_unknown.Range();
+        unknown.start = std::max(unknown.start, scope.start);
+        unknown.end = std::min(unknown.end, scope.end);
+        if (!unknown.Empty()) {
+            old = SubtractRanges(old, {unknown});
+            maybe.push_back(unknown);
+            NormalizeRanges(maybe);
+        }
+        if (m_unknown.Range().start >= scope.start && m_unknown.Range().end <= scope.end) m_unknown.Clear();
+    }
+
+    IndicatorDelta delta;
+    delta.clear = SubtractRanges(maybe, ranges);
+    delta.fill = SubtractRanges(ranges, old);
+    m_stats.clearCalls += delta.clear.size();
+    m_stats.fillCalls += delta.fill.size();
+
+    // Splice the new ranges in, keeping the parts of old ranges outside scope.
+    // The neighbours on either side join in so touching ranges get merged.
+    if (first != m_applied.begin()) --first;
+    if (last != m_applied.end()) ++last;
+    std::vector<TextRange> spliced = SubtractRanges(std::vector<TextRange>(first, last), {scope});
+    spliced.insert(spliced.end(), ranges.begin(), ranges.end());
+    NormalizeRanges(spliced);
+    size_t index = first - m_applied.begin();
+    m_applied.erase(first, last);
+    m_applied.insert(m_applied.begin() + index, spliced.begin(), spliced.end());
+
+    return delta;
+}
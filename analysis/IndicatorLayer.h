@@ -0,0 +1,50 @@
+#ifndef GROUP56_WORK_INDICATORLAYER_H
+#define GROUP56_WORK_INDICATORLAYER_H
+
+#include <cstdint>
+#include <vector>
+#include "DirtyRange.h"
+#include "TextRange.h"
+
+// The IndicatorClearRange / IndicatorFillRange calls that turn the ranges
+// currently on screen into the requested ones
+struct IndicatorDelta {
+    std::vector<TextRange> clear;
+    std::vector<TextRange> fill;
+};
+
+// How much work the diffing saved
+struct IndicatorStats {
+    uint64_t rangesRequested = 0;  // ranges handed to Update, before merging
+    uint64_t fillCalls = 0;
+    uint64_t clearCalls = 0;
+};
+
+// Mirror of the ranges one Scintilla indicator currently covers, so a new
+// analysis result only touches what actually changed. Edits are mirrored
+// the way Scintilla moves decorations; text inserted at the edge of a range
+// is where the two could disagree, so it is marked unknown and always
+// cleared or filled explicitly by the next update covering it.
+class IndicatorLayer {
+public:
+    void NoteInsert(size_t position, size_t length);
+    void NoteDelete(size_t position, size_t length);
+
+    // Replaces whatever is applied inside `scope` by `ranges` (in any order,
+    // possibly overlapping or adjacent) and returns the calls to make. The
+    // clear and fill lists are sorted, disjoint and merged.
+    IndicatorDelta Update(const TextRange& scope, std::vector<TextRange> ranges);
+
+    // The indicator was wiped outside our control (e.g. a new document)
+    void Reset();
+
+    const std::vector<TextRange>& Applied() const { return m_applied; }
+    const IndicatorStats& Stats() const { return m_stats; }
+
+private:
+    std::vector<TextRange> m_applied;  // sorted, disjoint, never adjacent
+    DirtyRange m_unknown;
+    IndicatorStats m_stats;
+};
+
+#endif //GROUP56_WORK_INDICATORLAYER_H
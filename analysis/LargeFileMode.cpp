@@ -0,0 +1,91 @@
+#include "LargeFileMode.h"
+
+#include <algorithm>
+#include <cstring>
+#include "Lexer.h"
+
+namespace {
+
+struct FeatureInfo {
+    LargeFileFeature feature;
+    const char* name;
+    const char* label;
+};
+
+const FeatureInfo kFeatures[] = {
+        {kSyntaxColouring, "syntaxColouring", "syntax colouring"},
+        {kCodeAnalysis, "codeAnalysis", "code analysis"},
+        {kBraceMatching, "braceMatching", "brace matching"},
+        {kWordWrap, "wordWrap", "word wrap"},
+};
+
+bool Reaches(size_t value, size_t threshold) {
+    return threshold > 0 && value >= threshold;
+}
+
+} // namespace
+
+const char* FeatureLabel(LargeFileFeature feature) {
+    for (const auto& info : kFeatures) {
+        if (info.feature == feature) return info.label;
+    }
+    return "";
+}
+
+uint32_t FeatureFromName(std::string_view name) {
+    for (const auto& info : kFeatures) {
+        if (name == info.name) return info.feature;
+    }
+    return 0;
+}
+
+DocumentShape MeasureDocument(std::string_view text) {
+    DocumentShape shape;
+    shape.bytes = text.size();
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* p = begin; p < end;) {
+        // memchr is vectorised in every mainstream libc
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', end - p));
+        const char* stop = nl ? nl : end;
+        size_t length = stop - p;
+        if (length > 0 && stop[-1] == '\r') length--;
+        shape.longestLine = std::max(shape.longestLine, length);
+        if (!nl) break;
+        shape.lines++;
+        p = nl + 1;
+    }
+    return shape;
+}
+
+LargeFilePolicy::LargeFilePolicy() : m_tiers(DefaultTiers()) {}
+
+// Wrapping lays out every line, and the bracket index lexes the whole
+// document on the UI thread, so those go first, from the line length at
+// which lexing is capped. Analysis runs on the worker but keeps several
+// times the document's size in tokens and line facts. Colouring is lazy
+// and capped per line, but Scintilla still lays out a line in one go.
+std::vector<LargeFileTier> LargeFilePolicy::DefaultTiers() {
+    return {
+            {"Large", 16u << 20, 250000, kLongLineBytes, kWordWrap | kBraceMatching},
+            {"Huge", 128u << 20, 2000000, 1u << 20, kCodeAnalysis},
+            {"Giant", 512u << 20, 8000000, 16u << 20, kSyntaxColouring},
+    };
+}
+
+int LargeFilePolicy::TierFor(const DocumentShape& shape) const {
+    for (size_t i = m_tiers.size(); i-- > 0;) {
+        const LargeFileTier& tier = m_tiers[i];
+        if (Reaches(shape.bytes, tier.bytes) || Reaches(shape.lines, tier.lines) ||
+            Reaches(shape.longestLine, tier.longestLine)) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+uint32_t LargeFilePolicy::DisabledIn(int tier) const {
+    uint32_t disabled = 0;
+    for (int i = 0; i <= tier && i < static_cast<int>(m_tiers.size()); ++i) disabled |= m_tiers[i].disabled;
+    return disabled;
+}
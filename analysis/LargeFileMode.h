@@ -0,0 +1,65 @@
+#ifndef GROUP56_WORK_LARGEFILEMODE_H
+#define GROUP56_WORK_LARGEFILEMODE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Editor features a large document can be opened without
+enum LargeFileFeature : uint32_t {
+    kSyntaxColouring = 1 << 0,
+    kCodeAnalysis = 1 << 1,   // variable, function and error indicators
+    kBraceMatching = 1 << 2,  // brace highlight and unmatched brackets
+    kWordWrap = 1 << 3,
+};
+const LargeFileFeature kLargeFileFeatures[] = {kSyntaxColouring, kCodeAnalysis, kBraceMatching, kWordWrap};
+
+// "syntax colouring" and so on, for menus and the status bar
+const char* FeatureLabel(LargeFileFeature feature);
+// The feature called `name` in tier configuration ("syntaxColouring", ...),
+// or 0 if there is none
+uint32_t FeatureFromName(std::string_view name);
+
+// What decides whether a document counts as large
+struct DocumentShape {
+    size_t bytes = 0;
+    size_t lines = 1;
+    size_t longestLine = 0;  // in bytes, without its line break
+};
+
+// One pass over text
+DocumentShape MeasureDocument(std::string_view text);
+
+// A document reaching any of a tier's thresholds (0 means not used) gets
+// the tier's features turned off
+struct LargeFileTier {
+    std::string name;
+    size_t bytes = 0;
+    size_t lines = 0;
+    size_t longestLine = 0;
+    uint32_t disabled = 0;  // LargeFileFeature bits
+};
+
+// Which features a document is opened without. Tiers go from mild to
+// severe; a document is in the last tier it reaches and loses the features
+// of that tier and every tier before it.
+class LargeFilePolicy {
+public:
+    LargeFilePolicy();  // with DefaultTiers()
+
+    static std::vector<LargeFileTier> DefaultTiers();
+
+    void SetTiers(std::vector<LargeFileTier> tiers) { m_tiers = std::move(tiers); }
+    const std::vector<LargeFileTier>& Tiers() const { return m_tiers; }
+
+    // Index of the tier shape is in, or -1 for an ordinary document
+    int TierFor(const DocumentShape& shape) const;
+    // The features turned off in tier `tier`
+    uint32_t DisabledIn(int tier) const;
+
+private:
+    std::vector<LargeFileTier> m_tiers;
+};
+
+#endif //GROUP56_WORK_LARGEFILEMODE_H
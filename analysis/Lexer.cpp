@@ -0,0 +1,143 @@
+#include "Lexer.h"
+
+#include <algorithm>
+
+namespace {
+
+bool IsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+bool IsWordChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+}
+
+bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Position of the "*/" closing a block comment within [pos, end), or npos
+size_t FindCommentClose(std::string_view text, size_t pos, size_t end) {
+    size_t close = std::string_view(text.data() + pos, end - pos).find("*/");
+    return close == std::string_view::npos ? std::string::npos : pos + close;
+}
+
+// Last non-newline character of the line is a backslash
+bool ContinuesLine(std::string_view text, size_t begin, size_t end) {
+    while (end > begin && (text[end - 1] == '\n' || text[end - 1] == '\r')) end--;
+    return end > begin && text[end - 1] == '\\';
+}
+
+void Push(std::vector<Token>& out, size_t start, size_t stop, uint32_t line, TokenKind kind, uint8_t flags = 0) {
+    Token token;
+    token.offset = static_cast<uint32_t>(start);
+    token.length = static_cast<uint32_t>(stop - start);
+    token.line = line;
+    token.kind = kind;
+    token.flags = flags;
+    out.push_back(token);
+}
+
+} // namespace
+
+LexState LexLine(std::string_view text, size_t begin, size_t end, uint32_t line,
+                 LexState state, std::vector<Token>& out) {
+    end = std::min(end, begin + kLongLineBytes);
+    size_t pos = begin;
+
+    // Carry on a directive or comment from the previous line
+    if (state == LexState::Preprocessor) {
+        Push(out, begin, end, line, TokenKind::Preprocessor);
+        return ContinuesLine(text, begin, end) ? LexState::Preprocessor : LexState::Default;
+    }
+    if (state == LexState::BlockComment) {
+        size_t close = FindCommentClose(text, pos, end);
+        if (close == std::string::npos) {
+            if (end > begin) Push(out, begin, end, line, TokenKind::Comment);
+            return LexState::BlockComment;
+        }
+        Push(out, begin, close + 2, line, TokenKind::Comment);
+        pos = close + 2;
+    }
+
+    bool lineStart = pos == begin;
+    while (pos < end) {
+        char c = text[pos];
+        if (IsSpace(c)) {
+            pos++;
+            continue;
+        }
+
+        size_t start = pos;
+        if (c == '#' && lineStart) {
+            Push(out, start, end, line, TokenKind::Preprocessor);
+            return ContinuesLine(text, start, end) ? LexState::Preprocessor : LexState::Default;
+        }
+        lineStart = false;
+
+        if (c == '/' && pos + 1 < end && text[pos + 1] == '/') {
+            // Line comment: up to (not including) the newline
+            size_t stop = end;
+            while (stop > start && (text[stop - 1] == '\n' || text[stop - 1] == '\r')) stop--;
+            Push(out, start, stop, line, TokenKind::Comment);
+            return LexState::Default;
+        }
+        if (c == '/' && pos + 1 < end && text[pos + 1] == '*') {
+            size_t close = FindCommentClose(text, pos + 2, end);
+            if (close == std::string::npos) {
+                Push(out, start, end, line, TokenKind::Comment);
+                return LexState::BlockComment;
+            }
+            pos = close + 2;
+            Push(out, start, pos, line, TokenKind::Comment);
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            pos++;
+            uint8_t flags = kTokenUnterminated;
+            while (pos < end && text[pos] != '\n') {
+                if (text[pos] == '\\' && pos + 1 < end) {
+                    pos += 2;
+                    continue;
+                }
+                if (text[pos++] == c) {
+                    flags = 0;
+                    break;
+                }
+            }
+            Push(out, start, pos, line, c == '"' ? TokenKind::String : TokenKind::Character, flags);
+            continue;
+        }
+        if (IsDigit(c) || (c == '.' && pos + 1 < end && IsDigit(text[pos + 1]))) {
+            pos++;
+            while (pos < end && (IsWordChar(text[pos]) || text[pos] == '.' || text[pos] == '\'')) pos++;
+            Push(out, start, pos, line, TokenKind::Number);
+            continue;
+        }
+        if (IsWordChar(c)) {
+            while (pos < end && IsWordChar(text[pos])) pos++;
+            Push(out, start, pos, line, TokenKind::Identifier);
+            continue;
+        }
+
+        pos++;
+        Push(out, start, pos, line, TokenKind::Punctuation);
+    }
+    return LexState::Default;
+}
+
+std::vector<Token> Tokenize(std::string_view text) {
+    std::vector<Token> tokens;
+    tokens.reserve(text.size() / 4);
+
+    LexState state = LexState::Default;
+    uint32_t line = 0;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t nl = text.find('\n', pos);
+        size_t stop = nl == std::string::npos ? text.size() : nl + 1;
+        state = LexLine(text, pos, stop, line++, state, tokens);
+        pos = stop;
+    }
+    return tokens;
+}
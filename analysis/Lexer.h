@@ -0,0 +1,68 @@
+#ifndef GROUP56_WORK_LEXER_H
+#define GROUP56_WORK_LEXER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+enum class TokenKind : uint8_t {
+    Identifier,    // keywords included
+    Number,
+    String,
+    Character,
+    Comment,
+    Preprocessor,
+    Punctuation,   // one character per token
+};
+
+// Token flags
+const uint8_t kTokenUnterminated = 1;  // string or character literal missing its closing quote
+
+// One lexed token. Kept small: large documents produce millions of these.
+struct Token {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+    uint32_t line = 0;
+    TokenKind kind = TokenKind::Punctuation;
+    uint8_t flags = 0;
+
+    uint32_t End() const { return offset + length; }
+};
+
+// Lexer state carried from the end of one line to the start of the next
+enum class LexState : uint8_t {
+    Default,
+    BlockComment,
+    Preprocessor,  // directive continued with a trailing backslash
+};
+
+// Lines longer than this (minified code, data dumps) are only lexed over
+// their first kLongLineBytes bytes. The rest of such a line has no tokens,
+// so it is plain text to colouring, brace matching and analysis alike, and
+// the line ends in the state lexing reached. Everything that works a line
+// at a time then costs at most this much per line, however long it is.
+const size_t kLongLineBytes = 64 << 10;
+
+// Lexes the single line text[begin, end) (end just past its newline, if any)
+// starting in `state`, appending its tokens to `out`. Returns the state at
+// the end of the line. Only the first kLongLineBytes are lexed.
+LexState LexLine(std::string_view text, size_t begin, size_t end, uint32_t line,
+                 LexState state, std::vector<Token>& out);
+
+// Lexes the whole of text from the default state
+std::vector<Token> Tokenize(std::string_view text);
+
+inline std::string_view TokenText(std::string_view text, const Token& token) {
+    return std::string_view(text.data() + token.offset, token.length);
+}
+
+inline bool IsPunctuation(std::string_view text, const Token& token, char c) {
+    return token.kind == TokenKind::Punctuation && text[token.offset] == c;
+}
+
+inline bool IsWord(std::string_view text, const Token& token, std::string_view word) {
+    return token.kind == TokenKind::Identifier && TokenText(text, token) == word;
+}
+
+#endif //GROUP56_WORK_LEXER_H
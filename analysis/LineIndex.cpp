@@ -0,0 +1,23 @@
+#include "LineIndex.h"
+
+#include <algorithm>
+#include <cstring>
+
+void LineIndex::Build(std::string_view text) {
+    m_starts.clear();
+    m_starts.push_back(0);
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    for (const char* p = begin; p < end;) {
+        // memchr is vectorised in every mainstream libc
+        const void* nl = std::memchr(p, '\n', end - p);
+        if (!nl) break;
+        p = static_cast<const char*>(nl) + 1;
+        m_starts.push_back(p - begin);
+    }
+}
+
+size_t LineIndex::LineOf(size_t pos) const {
+    if (m_starts.empty()) return 0;
+    return std::upper_bound(m_starts.begin(), m_starts.end(), pos) - m_starts.begin() - 1;
+}
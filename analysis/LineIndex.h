@@ -0,0 +1,26 @@
+#ifndef GROUP56_WORK_LINEINDEX_H
+#define GROUP56_WORK_LINEINDEX_H
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// Start offsets of every line of a document, for mapping byte offsets to
+// lines and back without rescanning the text
+class LineIndex {
+public:
+    void Build(std::string_view text);
+    void Clear() { m_starts.clear(); }
+    bool Empty() const { return m_starts.empty(); }
+
+    size_t LineCount() const { return m_starts.size(); }
+    size_t LineStart(size_t line) const { return m_starts[line]; }
+
+    // Line containing the byte at pos (the last line for pos past the end)
+    size_t LineOf(size_t pos) const;
+
+private:
+    std::vector<size_t> m_starts;
+};
+
+#endif //GROUP56_WORK_LINEINDEX_H
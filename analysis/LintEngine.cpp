@@ -0,0 +1,334 @@
+#include "LintEngine.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// How a token is spaced from the one before it, the low part of a symbol
+const size_t kGlued = 0;
+const size_t kSpaced = 1;
+const size_t kNewLine = 2;
+const size_t kSpacings = 3;
+
+const uint8_t kNoClass = 0xFF;
+
+template <typename Fn>
+void ForEachWord(std::string_view values, Fn fn) {
+    size_t pos = 0;
+    while (pos < values.size()) {
+        size_t stop = values.find(' ', pos);
+        if (stop == std::string_view::npos) stop = values.size();
+        if (stop > pos) fn(values.substr(pos, stop - pos));
+        pos = stop + 1;
+    }
+}
+
+bool SpacingAllows(LintSpacing spacing, size_t attribute) {
+    switch (spacing) {
+        case LintSpacing::Any: return true;
+        case LintSpacing::Glued: return attribute == kGlued;
+        case LintSpacing::Spaced: return attribute != kGlued;
+        case LintSpacing::SameLine: return attribute != kNewLine;
+    }
+    return false;
+}
+
+} // namespace
+
+LintEngine::LintEngine(std::vector<LintRule> rules) : m_rules(std::move(rules)) {
+    Compile();
+}
+
+size_t LintEngine::Bucket(std::string_view spelling) {
+    return (spelling.size() * 31 + static_cast<unsigned char>(spelling.front()) * 7 +
+            static_cast<unsigned char>(spelling.back())) % kBuckets;
+}
+
+uint8_t LintEngine::FindSpelling(TokenKind kind, std::string_view spelling) const {
+    for (uint8_t i = m_buckets[Bucket(spelling)]; i != kNoClass; i = m_spellings[i].next) {
+        if (m_spellings[i].kind == kind && m_spellings[i].text == spelling) return m_spellings[i].tokenClass;
+    }
+    return kNoClass;
+}
+
+void LintEngine::AddSpelling(TokenKind kind, std::string_view spelling, uint8_t& classes) {
+    if (spelling.empty() || FindSpelling(kind, spelling) != kNoClass) return;
+    size_t bucket = Bucket(spelling);
+    m_spellings.push_back({std::string(spelling), kind, classes++, m_buckets[bucket]});
+    m_buckets[bucket] = static_cast<uint8_t>(m_spellings.size() - 1);
+}
+
+void LintEngine::Compile() {
+    // Token classes: everything the rules spell out, then the catch-alls
+    uint8_t classes = 0;
+    std::memset(m_punct, kNoClass, sizeof(m_punct));
+    std::memset(m_buckets, kNoClass, sizeof(m_buckets));
+    for (const LintRule& rule : m_rules) {
+        for (const LintStep& step : rule.steps) {
+            std::string_view values = step.values;
+            if (step.match == LintMatch::Word) {
+                ForEachWord(values, [&](std::string_view word) { AddSpelling(TokenKind::Identifier, word, classes); });
+            } else if (step.match == LintMatch::Number) {
+                ForEachWord(values, [&](std::string_view number) { AddSpelling(TokenKind::Number, number, classes); });
+            } else if (step.match == LintMatch::Punct || step.match == LintMatch::NotPunct) {
+                for (unsigned char c : values) {
+                    if (m_punct[c] == kNoClass) m_punct[c] = classes++;
+                }
+            }
+        }
+    }
+    m_unterminatedClass = classes++;
+    m_otherClass = classes++;
+    m_endClass = classes++;
+    m_symbolCount = classes * kSpacings;
+
+    // The symbols each step accepts
+    m_stepSymbols.clear();
+    for (const LintRule& rule : m_rules) {
+        std::vector<SymbolSet> steps;
+        for (const LintStep& step : rule.steps) {
+            std::vector<bool> accepted(classes, false);
+            std::string_view values = step.values;
+            switch (step.match) {
+                case LintMatch::Word:
+                    ForEachWord(values, [&](std::string_view word) {
+                        accepted[FindSpelling(TokenKind::Identifier, word)] = true;
+                    });
+                    break;
+                case LintMatch::Number:
+                    ForEachWord(values, [&](std::string_view number) {
+                        accepted[FindSpelling(TokenKind::Number, number)] = true;
+                    });
+                    break;
+                case LintMatch::Punct:
+                    for (unsigned char c : values) accepted[m_punct[c]] = true;
+                    break;
+                case LintMatch::NotPunct:
+                    accepted.assign(classes, true);
+                    for (unsigned char c : values) accepted[m_punct[c]] = false;
+                    accepted[m_endClass] = false;
+                    break;
+                case LintMatch::UnterminatedString:
+                    accepted[m_unterminatedClass] = true;
+                    break;
+                case LintMatch::Any:
+                    accepted.assign(classes, true);
+                    accepted[m_endClass] = false;
+                    break;
+                case LintMatch::LineEnd:
+                    accepted.assign(classes, true);
+                    break;
+            }
+
+            SymbolSet symbols;
+            for (size_t c = 0; c < classes; ++c) {
+                if (!accepted[c]) continue;
+                for (size_t attribute = 0; attribute < kSpacings; ++attribute) {
+                    bool allowed = step.match == LintMatch::LineEnd ? attribute == kNewLine
+                                                                    : SpacingAllows(step.spacing, attribute);
+                    if (allowed) symbols.set(c * kSpacings + attribute);
+                }
+            }
+            steps.push_back(symbols);
+        }
+        m_stepSymbols.push_back(std::move(steps));
+    }
+
+    // Subset construction. An item is (rule, steps matched so far); every
+    // state also holds the start items, since a match may begin at any token.
+    std::vector<size_t> itemBase;
+    size_t itemCount = 0;
+    for (const LintRule& rule : m_rules) {
+        itemBase.push_back(itemCount);
+        itemCount += rule.steps.size() + 1;
+    }
+    auto closure = [&](std::vector<uint16_t>& items) {
+        for (size_t i = 0; i < items.size(); ++i) {
+            size_t rule = std::upper_bound(itemBase.begin(), itemBase.end(), items[i]) - itemBase.begin() - 1;
+            size_t step = items[i] - itemBase[rule];
+            if (step < m_rules[rule].steps.size() && m_rules[rule].steps[step].repeat) {
+                uint16_t skip = static_cast<uint16_t>(items[i] + 1);
+                if (std::find(items.begin(), items.end(), skip) == items.end()) items.push_back(skip);
+            }
+        }
+        std::sort(items.begin(), items.end());
+        items.erase(std::unique(items.begin(), items.end()), items.end());
+    };
+
+    std::vector<uint16_t> startItems;
+    for (size_t base : itemBase) startItems.push_back(static_cast<uint16_t>(base));
+    closure(startItems);
+
+    std::map<std::vector<uint16_t>, uint16_t> ids;
+    std::vector<std::vector<uint16_t>> states;
+    auto intern = [&](const std::vector<uint16_t>& items) {
+        auto found = ids.find(items);
+        if (found != ids.end()) return found->second;
+        uint16_t id = static_cast<uint16_t>(states.size());
+        ids.emplace(items, id);
+        states.push_back(items);
+
+        uint32_t accepts = 0;
+        for (size_t rule = 0; rule < m_rules.size(); ++rule) {
+            uint16_t done = static_cast<uint16_t>(itemBase[rule] + m_rules[rule].steps.size());
+            if (std::binary_search(items.begin(), items.end(), done)) accepts |= 1u << rule;
+        }
+        m_accepts.push_back(accepts);
+        return id;
+    };
+
+    m_next.clear();
+    m_accepts.clear();
+    m_start = intern(startItems);
+    for (size_t state = 0; state < states.size(); ++state) {
+        m_next.resize((state + 1) * m_symbolCount);
+        for (size_t symbol = 0; symbol < m_symbolCount; ++symbol) {
+            std::vector<uint16_t> next = startItems;
+            for (uint16_t item : states[state]) {
+                size_t rule = std::upper_bound(itemBase.begin(), itemBase.end(), item) - itemBase.begin() - 1;
+                size_t step = item - itemBase[rule];
+                if (step == m_rules[rule].steps.size() || !m_stepSymbols[rule][step][symbol]) continue;
+                next.push_back(m_rules[rule].steps[step].repeat ? item : static_cast<uint16_t>(item + 1));
+            }
+            closure(next);
+            // intern may grow `states`, so don't hold references into it
+            m_next[state * m_symbolCount + symbol] = intern(next);
+        }
+    }
+}
+
+size_t LintEngine::Symbol(std::string_view text, const std::vector<Token>& tokens, size_t i) const {
+    if (i < tokens.size()) return TokenSymbol(text, tokens, i);
+    // A newline ending the last token's line, even when that token runs on past it
+    bool newline = !tokens.empty() && text.find('\n', tokens.back().offset) != std::string_view::npos;
+    return m_endClass * kSpacings + (newline ? kNewLine : kGlued);
+}
+
+size_t LintEngine::TokenSymbol(std::string_view text, const std::vector<Token>& tokens, size_t i) const {
+    const Token& token = tokens[i];
+    size_t attribute = kNewLine;
+    if (i > 0 && token.line == tokens[i - 1].line) {
+        attribute = token.offset == tokens[i - 1].End() ? kGlued : kSpaced;
+    }
+
+    uint8_t tokenClass = kNoClass;
+    switch (token.kind) {
+        case TokenKind::Identifier:
+        case TokenKind::Number:
+            tokenClass = FindSpelling(token.kind, TokenText(text, token));
+            break;
+        case TokenKind::Punctuation:
+            tokenClass = m_punct[static_cast<unsigned char>(text[token.offset])];
+            break;
+        case TokenKind::String:
+            if (token.flags & kTokenUnterminated) tokenClass = m_unterminatedClass;
+            break;
+        default:
+            break;
+    }
+    if (tokenClass == kNoClass) tokenClass = m_otherClass;
+    return tokenClass * kSpacings + attribute;
+}
+
+// Runs the rule's steps backwards from the token it accepted on and returns
+// the earliest token a match can start at
+size_t LintEngine::FindStart(size_t rule, std::string_view text, const std::vector<Token>& tokens,
+                             size_t end) const {
+    const std::vector<LintStep>& steps = m_rules[rule].steps;
+    const std::vector<SymbolSet>& symbols = m_stepSymbols[rule];
+
+    // Bit k set: the tokens after the current one matched steps [k, size)
+    auto closure = [&](uint64_t set) {
+        for (size_t k = steps.size(); k > 0; --k) {
+            if ((set >> k & 1) && steps[k - 1].repeat) set |= uint64_t(1) << (k - 1);
+        }
+        return set;
+    };
+
+    size_t start = SIZE_MAX;
+    uint64_t set = closure(uint64_t(1) << steps.size());
+    for (size_t i = end + 1; i-- > 0 && set > 1;) {
+        size_t symbol = Symbol(text, tokens, i);
+        uint64_t next = 0;
+        for (size_t k = 1; k <= steps.size(); ++k) {
+            if (!(set >> k & 1) || !symbols[k - 1][symbol]) continue;
+            next |= uint64_t(1) << (steps[k - 1].repeat ? k : k - 1);
+        }
+        set = closure(next);
+        if (set & 1) start = i;
+    }
+    return start;
+}
+
+void LintEngine::Run(std::string_view text, const std::vector<Token>& tokens, size_t limit, uint32_t context,
+                     std::vector<TextRange>& out, LintStats& stats) const {
+    std::vector<LintHit> hits;
+    Run(text, tokens, limit, hits, stats);
+    for (const LintHit& hit : hits) {
+        if (!(m_rules[hit.rule].skipIf & context)) out.push_back(hit.range);
+    }
+}
+
+void LintEngine::Run(std::string_view text, const std::vector<Token>& tokens, size_t limit,
+                     std::vector<LintHit>& out, LintStats& stats) const {
+    auto began = Clock::now();
+    if (stats.rules.size() < m_rules.size()) stats.rules.resize(m_rules.size());
+    for (size_t rule = 0; rule < m_rules.size(); ++rule) stats.rules[rule].name = m_rules[rule].name;
+    stats.runs++;
+    stats.tokens += tokens.size();
+    if (tokens.empty()) return;
+
+    size_t firstOut = out.size();
+    std::chrono::nanoseconds resolving{0};
+    // The end of the input is one more symbol, for rules ending in LineEnd
+    uint16_t state = m_start;
+    for (size_t i = 0; i <= tokens.size(); ++i) {
+        size_t symbol = i < tokens.size() ? TokenSymbol(text, tokens, i) : Symbol(text, tokens, i);
+        state = m_next[state * m_symbolCount + symbol];
+        if (m_accepts[state]) Report(m_accepts[state], text, tokens, i, limit, out, stats, resolving);
+    }
+
+    std::sort(out.begin() + firstOut, out.end(),
+              [](const LintHit& a, const LintHit& b) { return a.range.start < b.range.start; });
+    stats.scanTime += Clock::now() - began - resolving;
+}
+
+void LintEngine::Report(uint32_t accepts, std::string_view text, const std::vector<Token>& tokens, size_t i,
+                        size_t limit, std::vector<LintHit>& out, LintStats& stats,
+                        std::chrono::nanoseconds& resolving) const {
+    for (size_t rule = 0; rule < m_rules.size(); ++rule) {
+        if (!(accepts >> rule & 1)) continue;
+        auto resolveBegan = Clock::now();
+
+        const LintRule& lint = m_rules[rule];
+        size_t start = FindStart(rule, text, tokens, i);
+        size_t last = lint.steps.back().match == LintMatch::LineEnd ? i - 1 : i;
+        if (start < limit && start <= last && last < tokens.size()) {
+            const Token& first = tokens[start];
+            TextRange range;
+            switch (lint.extent) {
+                case LintExtent::Tokens:
+                    range = {first.offset, tokens[last].End()};
+                    break;
+                case LintExtent::ThroughLineEnd: {
+                    size_t nl = text.find('\n', tokens[last].offset);
+                    range = {first.offset, nl == std::string_view::npos ? text.size() : nl + 1};
+                    break;
+                }
+                case LintExtent::FirstByte:
+                    range = {first.offset, first.offset + 1};
+                    break;
+            }
+            out.push_back({range, static_cast<uint8_t>(rule)});
+            stats.rules[rule].hits++;
+        }
+
+        auto spent = Clock::now() - resolveBegan;
+        stats.rules[rule].time += spent;
+        resolving += spent;
+    }
+}
@@ -0,0 +1,155 @@
+#ifndef GROUP56_WORK_LINTENGINE_H
+#define GROUP56_WORK_LINTENGINE_H
+
+#include <bitset>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Lexer.h"
+#include "TextRange.h"
+
+// What one step of a rule's token pattern accepts. `values` lists the
+// accepted spellings: space-separated words for Word and Number, single
+// characters for Punct and NotPunct.
+enum class LintMatch : uint8_t {
+    Word,                // identifier spelled as one of the values
+    Number,              // number literal spelled as one of the values
+    Punct,               // one of the punctuation characters
+    NotPunct,            // any token except those punctuation characters
+    UnterminatedString,
+    Any,
+    LineEnd,             // the first token of a later line, or a newline at the end;
+                         // only as the last step, and not part of the highlight
+};
+
+// How a token has to sit relative to the token before it
+enum class LintSpacing : uint8_t {
+    Any,
+    Glued,     // directly after it
+    Spaced,    // after whitespace, which may include line breaks
+    SameLine,  // on the same line
+};
+
+struct LintStep {
+    LintMatch match;
+    const char* values = "";
+    LintSpacing spacing = LintSpacing::Any;
+    bool repeat = false;  // zero or more tokens instead of exactly one
+};
+
+// The part of a match that gets highlighted
+enum class LintExtent : uint8_t {
+    Tokens,          // first to last matched token
+    ThroughLineEnd,  // first matched token through the end of the line the last one starts on
+    FirstByte,
+};
+
+struct LintRule {
+    const char* name;
+    std::vector<LintStep> steps;
+    LintExtent extent = LintExtent::Tokens;
+    uint32_t skipIf = 0;  // context flags under which the rule is off
+};
+
+// One match: what to highlight and which rule matched
+struct LintHit {
+    TextRange range;
+    uint8_t rule;
+};
+
+struct LintRuleStats {
+    const char* name = "";
+    uint64_t hits = 0;
+    std::chrono::nanoseconds time{0};  // finding the start and extent of its hits
+};
+
+// Counters for LintEngine::Run. The automaton pass is shared by all rules,
+// so its time can't be split between them and is reported on its own.
+struct LintStats {
+    uint64_t runs = 0;
+    uint64_t tokens = 0;
+    std::chrono::nanoseconds scanTime{0};
+    std::vector<LintRuleStats> rules;
+
+    void Add(const LintStats& other) {
+        runs += other.runs;
+        tokens += other.tokens;
+        scanTime += other.scanTime;
+        if (rules.size() < other.rules.size()) rules.resize(other.rules.size());
+        for (size_t i = 0; i < other.rules.size(); ++i) {
+            rules[i].name = other.rules[i].name;
+            rules[i].hits += other.rules[i].hits;
+            rules[i].time += other.rules[i].time;
+        }
+    }
+};
+
+// Checks a token stream against a table of token patterns in one pass. The
+// patterns are compiled together into a single DFA over token classes (the
+// words, numbers and punctuation the rules mention, each combined with how
+// the token is spaced from the one before), so the cost per token is one
+// classification and one table lookup however many rules there are. When a
+// rule accepts, its start is found by running that rule backwards from the
+// accepting token, taking the earliest start.
+//
+// Limits: 32 rules, 63 steps per rule, and 80 distinct spellings in all.
+class LintEngine {
+public:
+    explicit LintEngine(std::vector<LintRule> rules);
+
+    const std::vector<LintRule>& Rules() const { return m_rules; }
+
+    // Appends the matches starting in tokens[0, limit), sorted by start;
+    // the tokens after that are lookahead. Every rule is reported.
+    void Run(std::string_view text, const std::vector<Token>& tokens, size_t limit, std::vector<LintHit>& out,
+             LintStats& stats) const;
+
+    // The same, as highlights, leaving out rules whose skipIf shares a bit
+    // with `context`
+    void Run(std::string_view text, const std::vector<Token>& tokens, size_t limit, uint32_t context,
+             std::vector<TextRange>& out, LintStats& stats) const;
+
+private:
+    static constexpr size_t kMaxSymbols = 256;
+    using SymbolSet = std::bitset<kMaxSymbols>;
+
+    std::vector<LintRule> m_rules;
+    std::vector<std::vector<SymbolSet>> m_stepSymbols;  // per rule and step
+
+    // Token classes; a symbol is class * 3 + spacing (glued, spaced, new line).
+    // Spelled words and numbers sit in a small chained hash table, so most
+    // identifiers are turned away by an empty bucket without a comparison.
+    struct Spelling {
+        std::string text;
+        TokenKind kind;
+        uint8_t tokenClass;
+        uint8_t next;  // in the same bucket
+    };
+    static constexpr size_t kBuckets = 256;
+    std::vector<Spelling> m_spellings;
+    uint8_t m_buckets[kBuckets];
+    uint8_t m_punct[256];
+    uint8_t m_unterminatedClass = 0;
+    uint8_t m_otherClass = 0;
+    uint8_t m_endClass = 0;  // after the last token
+    size_t m_symbolCount = 0;
+
+    std::vector<uint16_t> m_next;      // m_next[state * m_symbolCount + symbol]
+    std::vector<uint32_t> m_accepts;   // rules accepting in each state
+    uint16_t m_start = 0;
+
+    static size_t Bucket(std::string_view spelling);
+    uint8_t FindSpelling(TokenKind kind, std::string_view spelling) const;
+    void AddSpelling(TokenKind kind, std::string_view spelling, uint8_t& classes);
+    void Compile();
+    // The symbol of tokens[i], or of the end of the input for i == tokens.size()
+    size_t Symbol(std::string_view text, const std::vector<Token>& tokens, size_t i) const;
+    size_t TokenSymbol(std::string_view text, const std::vector<Token>& tokens, size_t i) const;
+    size_t FindStart(size_t rule, std::string_view text, const std::vector<Token>& tokens, size_t end) const;
+    void Report(uint32_t accepts, std::string_view text, const std::vector<Token>& tokens, size_t i, size_t limit,
+                std::vector<LintHit>& out, LintStats& stats, std::chrono::nanoseconds& resolving) const;
+};
+
+#endif //GROUP56_WORK_LINTENGINE_H
@@ -0,0 +1,56 @@
+#ifndef GROUP56_WORK_RANGESET_H
+#define GROUP56_WORK_RANGESET_H
+
+#include <algorithm>
+#include <vector>
+#include "TextRange.h"
+
+// Helpers for sets of ranges kept as sorted, disjoint vectors
+
+// Drops empty ranges, sorts, and merges overlapping and adjacent ones
+inline void NormalizeRanges(std::vector<TextRange>& ranges) {
+    ranges.erase(std::remove_if(ranges.begin(), ranges.end(), [](const TextRange& r) { return r.Empty(); }),
+                 ranges.end());
+    std::sort(ranges.begin(), ranges.end(), [](const TextRange& a, const TextRange& b) { return a.start < b.start; });
+    size_t out = 0;
+    for (size_t i = 0; i < ranges.size(); ++i) {
+        if (out > 0 && ranges[i].start <= ranges[out - 1].end) {
+            ranges[out - 1].end = std::max(ranges[out - 1].end, ranges[i].end);
+        } else {
+            ranges[out++] = ranges[i];
+        }
+    }
+    ranges.resize(out);
+}
+
+// a minus b, both sorted and disjoint
+inline std::vector<TextRange> SubtractRanges(const std::vector<TextRange>& a, const std::vector<TextRange>& b) {
+    std::vector<TextRange> out;
+    size_t j = 0;
+    for (TextRange r : a) {
+        while (j < b.size() && b[j].end <= r.start) ++j;
+        for (size_t k = j; k < b.size() && b[k].start < r.end; ++k) {
+            if (b[k].start > r.start) out.push_back({r.start, b[k].start});
+            r.start = std::max(r.start, b[k].end);
+        }
+        if (!r.Empty()) out.push_back(r);
+    }
+    return out;
+}
+
+// Moves ranges along with an insert or delete: a range containing an
+// insertion grows, deleted text shrinks ranges away
+inline void ShiftRanges(std::vector<TextRange>& ranges, size_t position, size_t length, bool inserted) {
+    auto shift = [&](size_t p) {
+        if (inserted) return p > position ? p + length : p;
+        if (p >= position + length) return p - length;
+        return p > position ? position : p;
+    };
+    for (auto& r : ranges) {
+        r.start = shift(r.start);
+        r.end = shift(r.end);
+    }
+    NormalizeRanges(ranges);
+}
+
+#endif //GROUP56_WORK_RANGESET_H
@@ -0,0 +1,779 @@
+#include "RegexSearcher.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+
+namespace {
+
+// Patterns may have at most this many byte positions once `{m,n}` is
+// expanded, and repeat counts go up to kMaxRepeat. Parse trees are capped
+// at kMaxNodes while they are built, so a repeat of a repeat can't run away
+// before positions are counted, and groups nest at most kMaxDepth deep, the
+// parser being recursive.
+const size_t kMaxPositions = 4096;
+const int kMaxRepeat = 1000;
+const size_t kMaxNodes = 16 * kMaxPositions;
+const int kMaxDepth = 1000;
+
+enum class NodeKind : uint8_t { Bytes, Empty, Concat, Alternate, Star, Plus, Optional };
+
+// A node is always added after its children, so they have lower indices
+// and the tree can be walked bottom up by index, without recursion
+struct Node {
+    NodeKind kind = NodeKind::Empty;
+    int left = -1;
+    int right = -1;
+    std::bitset<256> bytes;  // for NodeKind::Bytes
+};
+
+// Which nodes are in the subtree under `root`, indexed up to it
+std::vector<bool> Subtree(const std::vector<Node>& nodes, int root) {
+    std::vector<bool> inside(root + 1, false);
+    inside[root] = true;
+    for (int i = root; i >= 0; --i) {
+        if (!inside[i]) continue;
+        if (nodes[i].left >= 0) inside[nodes[i].left] = true;
+        if (nodes[i].right >= 0) inside[nodes[i].right] = true;
+    }
+    return inside;
+}
+
+// Recursive descent over the pattern into a tree of Nodes
+class Parser {
+public:
+    Parser(std::string_view pattern, std::vector<Node>& nodes) : m_pattern(pattern), m_nodes(nodes) {}
+
+    // The root, or -1 with error set
+    int Parse(std::string& error) {
+        int root = ParseAlternation();
+        if (m_error.empty() && m_pos < m_pattern.size()) m_error = "unmatched )";
+        error = m_error;
+        return m_error.empty() ? root : -1;
+    }
+
+    // Whether there is a | outside any group
+    bool TopLevelAlternation() const { return m_topLevelAlternation; }
+
+private:
+    bool AtEnd() const { return m_pos >= m_pattern.size(); }
+    char Peek() const { return m_pattern[m_pos]; }
+
+    int Add(NodeKind kind, int left = -1, int right = -1) {
+        if (m_nodes.size() >= kMaxNodes && m_error.empty()) m_error = "pattern too large";
+        Node node;
+        node.kind = kind;
+        node.left = left;
+        node.right = right;
+        m_nodes.push_back(node);
+        return static_cast<int>(m_nodes.size()) - 1;
+    }
+
+    int AddBytes(const std::bitset<256>& bytes) {
+        int node = Add(NodeKind::Bytes);
+        m_nodes[node].bytes = bytes;
+        return node;
+    }
+
+    int AddByte(unsigned char c) {
+        std::bitset<256> bytes;
+        bytes.set(c);
+        return AddBytes(bytes);
+    }
+
+    int AddRange(unsigned lo, unsigned hi) {
+        std::bitset<256> bytes;
+        for (unsigned c = lo; c <= hi; ++c) bytes.set(c);
+        return AddBytes(bytes);
+    }
+
+    // Any ASCII byte outside `excluded`, or any multi-byte UTF-8 character
+    int AddNegated(const std::bitset<256>& excluded) {
+        std::bitset<256> ascii;
+        for (unsigned c = 0; c < 0x80; ++c) ascii.set(c, !excluded[c]);
+        int two = Add(NodeKind::Concat, AddRange(0xC0, 0xDF), AddRange(0x80, 0xBF));
+        int three = Add(NodeKind::Concat, Add(NodeKind::Concat, AddRange(0xE0, 0xEF), AddRange(0x80, 0xBF)),
+                        AddRange(0x80, 0xBF));
+        int four = Add(NodeKind::Concat,
+                       Add(NodeKind::Concat, Add(NodeKind::Concat, AddRange(0xF0, 0xF7), AddRange(0x80, 0xBF)),
+                           AddRange(0x80, 0xBF)),
+                       AddRange(0x80, 0xBF));
+        return Add(NodeKind::Alternate, Add(NodeKind::Alternate, AddBytes(ascii), two),
+                   Add(NodeKind::Alternate, three, four));
+    }
+
+    // A copy of the subtree, children first like any other
+    int Clone(int node) {
+        std::vector<bool> inside = Subtree(m_nodes, node);
+        std::vector<int> copies(node + 1, -1);
+        for (int i = 0; i <= node && m_error.empty(); ++i) {
+            if (!inside[i]) continue;
+            const Node& original = m_nodes[i];
+            copies[i] = Add(original.kind, original.left >= 0 ? copies[original.left] : -1,
+                            original.right >= 0 ? copies[original.right] : -1);
+            m_nodes[copies[i]].bytes = m_nodes[i].bytes;
+        }
+        return m_error.empty() ? copies[node] : Add(NodeKind::Empty);
+    }
+
+    int ParseAlternation() {
+        int node = ParseConcatenation();
+        while (m_error.empty() && !AtEnd() && Peek() == '|') {
+            if (m_depth == 0) m_topLevelAlternation = true;
+            m_pos++;
+            node = Add(NodeKind::Alternate, node, ParseConcatenation());
+        }
+        return node;
+    }
+
+    int ParseConcatenation() {
+        int node = -1;
+        while (m_error.empty() && !AtEnd() && Peek() != '|' && Peek() != ')') {
+            int next = ParseRepeat();
+            node = node < 0 ? next : Add(NodeKind::Concat, node, next);
+        }
+        return node < 0 ? Add(NodeKind::Empty) : node;
+    }
+
+    int ParseRepeat() {
+        int node = ParseAtom();
+        while (m_error.empty() && !AtEnd()) {
+            char c = Peek();
+            if (c == '*') {
+                node = Add(NodeKind::Star, node);
+            } else if (c == '+') {
+                node = Add(NodeKind::Plus, node);
+            } else if (c == '?') {
+                node = Add(NodeKind::Optional, node);
+            } else if (c == '{') {
+                node = ParseCount(node);
+                continue;
+            } else {
+                break;
+            }
+            m_pos++;
+            if (!AtEnd() && Peek() == '?') m_error = "lazy quantifiers aren't supported";
+        }
+        return node;
+    }
+
+    int ReadNumber() {
+        int value = -1;
+        while (!AtEnd() && Peek() >= '0' && Peek() <= '9' && value <= kMaxRepeat) {
+            value = std::max(value, 0) * 10 + (Peek() - '0');
+            m_pos++;
+        }
+        return value;
+    }
+
+    // {m}, {m,} or {m,n} after node, spelled out as copies of it
+    int ParseCount(int node) {
+        m_pos++;
+        int min = ReadNumber();
+        int max = min;
+        if (!AtEnd() && Peek() == ',') {
+            m_pos++;
+            max = AtEnd() || Peek() == '}' ? -1 : ReadNumber();
+            if (max < 0 && (AtEnd() || Peek() != '}')) min = -1;
+        }
+        if (min < 0 || AtEnd() || Peek() != '}') {
+            m_error = "malformed {m,n}";
+            return node;
+        }
+        m_pos++;
+        if (min > kMaxRepeat || max > kMaxRepeat || (max >= 0 && max < min)) {
+            m_error = "bad repeat count";
+            return node;
+        }
+        if (!AtEnd() && Peek() == '?') m_error = "lazy quantifiers aren't supported";
+
+        // x{2,4} is x x (x x?)?, x{2,} is x x+
+        int result = -1;
+        auto append = [&](int next) { result = result < 0 ? next : Add(NodeKind::Concat, result, next); };
+        for (int i = 1; i < min && m_error.empty(); ++i) append(Clone(node));
+        if (max < 0) {
+            append(Add(NodeKind::Plus, min > 0 ? node : Clone(node)));
+            if (min == 0) result = Add(NodeKind::Optional, result);
+        } else {
+            if (min > 0) append(node);
+            int optional = -1;
+            for (int i = min; i < max && m_error.empty(); ++i) {
+                int copy = Clone(node);
+                optional = Add(NodeKind::Optional, optional < 0 ? copy : Add(NodeKind::Concat, copy, optional));
+            }
+            if (optional >= 0) append(optional);
+        }
+        return result < 0 ? Add(NodeKind::Empty) : result;
+    }
+
+    // \d and the like as a set of ASCII bytes; false if c names none
+    static bool ShorthandClass(char c, std::bitset<256>& bytes) {
+        switch (c) {
+            case 'd':
+                for (unsigned b = '0'; b <= '9'; ++b) bytes.set(b);
+                return true;
+            case 'w':
+                for (unsigned b = 0; b < 0x80; ++b) {
+                    if (std::isalnum(static_cast<int>(b)) || b == '_') bytes.set(b);
+                }
+                return true;
+            case 's':
+                for (char b : {' ', '\t', '\n', '\r', '\f', '\v'}) bytes.set(static_cast<unsigned char>(b));
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // The byte an escape inside or outside [] stands for, or -1
+    int EscapedByte(char c) {
+        switch (c) {
+            case 'n': return '\n';
+            case 't': return '\t';
+            case 'r': return '\r';
+            case 'f': return '\f';
+            case 'v': return '\v';
+            default:
+                if (static_cast<unsigned char>(c) < 0x80 && !std::isalnum(static_cast<unsigned char>(c))) {
+                    return static_cast<unsigned char>(c);
+                }
+                m_error = std::string("unknown escape \\") + c;
+                return -1;
+        }
+    }
+
+    int ParseAtom() {
+        if (AtEnd()) return Add(NodeKind::Empty);
+        char c = m_pattern[m_pos++];
+        switch (c) {
+            case '(': {
+                if (m_pattern.compare(m_pos, 2, "?:") == 0) m_pos += 2;
+                if (m_depth == kMaxDepth) {
+                    m_error = "groups nested too deeply";
+                    return Add(NodeKind::Empty);
+                }
+                m_depth++;
+                int inner = ParseAlternation();
+                m_depth--;
+                if (m_error.empty() && (AtEnd() || Peek() != ')')) m_error = "missing )";
+                m_pos++;
+                return inner;
+            }
+            case '[':
+                return ParseClass();
+            case '.': {
+                std::bitset<256> newline;
+                newline.set('\n');
+                return AddNegated(newline);
+            }
+            case '\\': {
+                if (AtEnd()) {
+                    m_error = "pattern ends with \\";
+                    return Add(NodeKind::Empty);
+                }
+                char e = m_pattern[m_pos++];
+                std::bitset<256> bytes;
+                if (ShorthandClass(e, bytes)) return AddBytes(bytes);
+                if (ShorthandClass(static_cast<char>(std::tolower(static_cast<unsigned char>(e))), bytes)) {
+                    return AddNegated(bytes);
+                }
+                int byte = EscapedByte(e);
+                return byte < 0 ? Add(NodeKind::Empty) : AddByte(static_cast<unsigned char>(byte));
+            }
+            case '*':
+            case '+':
+            case '?':
+            case '{':
+                m_error = std::string("nothing to repeat before ") + c;
+                return Add(NodeKind::Empty);
+            case '^':
+            case '$':
+                m_error = "^ and $ may only open and close the pattern";
+                return Add(NodeKind::Empty);
+            default:
+                break;
+        }
+
+        // A multi-byte UTF-8 character is one atom, so x+ repeats all of it
+        int node = AddByte(static_cast<unsigned char>(c));
+        if (static_cast<unsigned char>(c) >= 0xC0) {
+            while (!AtEnd() && (static_cast<unsigned char>(Peek()) & 0xC0) == 0x80) {
+                node = Add(NodeKind::Concat, node, AddByte(static_cast<unsigned char>(m_pattern[m_pos++])));
+            }
+        }
+        return node;
+    }
+
+    int ParseClass() {
+        bool negated = !AtEnd() && Peek() == '^';
+        if (negated) m_pos++;
+        std::bitset<256> bytes;
+        for (bool first = true; m_error.empty(); first = false) {
+            if (AtEnd()) {
+                m_error = "missing ]";
+                break;
+            }
+            unsigned char c = static_cast<unsigned char>(m_pattern[m_pos++]);
+            if (c == ']' && !first) break;
+            int lo = c;
+            if (c == '\\') {
+                if (AtEnd()) continue;
+                char e = m_pattern[m_pos++];
+                if (ShorthandClass(e, bytes)) continue;
+                lo = EscapedByte(e);
+                if (lo < 0) break;
+            }
+            if (lo >= 0x80) {
+                m_error = "[ ] only takes ASCII characters";
+                break;
+            }
+            int hi = lo;
+            if (m_pos + 1 < m_pattern.size() && Peek() == '-' && m_pattern[m_pos + 1] != ']') {
+                hi = static_cast<unsigned char>(m_pattern[m_pos + 1]);
+                m_pos += 2;
+                if (hi == '\\' && !AtEnd()) hi = EscapedByte(m_pattern[m_pos++]);
+                if (hi < lo || hi >= 0x80) {
+                    m_error = "bad range in [ ]";
+                    break;
+                }
+            }
+            for (int b = lo; b <= hi; ++b) bytes.set(b);
+        }
+        return negated ? AddNegated(bytes) : AddBytes(bytes);
+    }
+
+    std::string_view m_pattern;
+    size_t m_pos = 0;
+    std::vector<Node>& m_nodes;
+    std::string m_error;
+    int m_depth = 0;  // groups open at m_pos
+    bool m_topLevelAlternation = false;
+};
+
+using Bits = std::vector<uint64_t>;
+
+void SetBit(Bits& bits, size_t i) {
+    bits[i / 64] |= uint64_t(1) << (i % 64);
+}
+
+bool TestBit(const Bits& bits, size_t i) {
+    return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+void OrInto(Bits& into, const Bits& bits) {
+    for (size_t i = 0; i < into.size(); ++i) into[i] |= bits[i];
+}
+
+bool Intersects(const Bits& a, const Bits& b) {
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] & b[i]) return true;
+    }
+    return false;
+}
+
+bool IsEmpty(const Bits& bits) {
+    return std::all_of(bits.begin(), bits.end(), [](uint64_t word) { return word == 0; });
+}
+
+// The position automaton of a parse tree: its states are 0 (start) and one
+// per Bytes node, and a state is entered only by a byte its node accepts.
+// follow[q] is the states that can come right after q.
+class Glushkov {
+public:
+    Glushkov(const std::vector<Node>& nodes, size_t words) : m_nodes(nodes), m_words(words) {}
+
+    struct Info {
+        bool nullable = false;
+        Bits first;
+        Bits last;
+    };
+
+    std::vector<Bits> follow;
+    std::vector<const std::bitset<256>*> bytes;  // per state; state 0 has none
+
+    // Numbers the positions under root and links them; returns root's Info
+    Info Build(int root) {
+        std::vector<bool> inside = Subtree(m_nodes, root);
+        std::vector<Info> infos(root + 1);
+        for (int i = 0; i <= root; ++i) {
+            if (inside[i]) infos[i] = Visit(i, infos);
+        }
+        return std::move(infos[root]);
+    }
+
+private:
+    // The node's Info from its children's, which are then no longer needed
+    Info Visit(int node, std::vector<Info>& infos) {
+        const Node& n = m_nodes[node];
+        Info info;
+        info.first.assign(m_words, 0);
+        info.last.assign(m_words, 0);
+        switch (n.kind) {
+            case NodeKind::Bytes: {
+                size_t state = bytes.size();
+                bytes.push_back(&n.bytes);
+                follow.emplace_back(m_words, 0);
+                SetBit(info.first, state);
+                SetBit(info.last, state);
+                break;
+            }
+            case NodeKind::Empty:
+                info.nullable = true;
+                break;
+            case NodeKind::Concat: {
+                Info a = std::move(infos[n.left]);
+                Info b = std::move(infos[n.right]);
+                Link(a.last, b.first);
+                info.nullable = a.nullable && b.nullable;
+                info.first = a.first;
+                if (a.nullable) OrInto(info.first, b.first);
+                info.last = b.last;
+                if (b.nullable) OrInto(info.last, a.last);
+                break;
+            }
+            case NodeKind::Alternate: {
+                Info a = std::move(infos[n.left]);
+                Info b = std::move(infos[n.right]);
+                info.nullable = a.nullable || b.nullable;
+                info.first = a.first;
+                OrInto(info.first, b.first);
+                info.last = a.last;
+                OrInto(info.last, b.last);
+                break;
+            }
+            case NodeKind::Star:
+            case NodeKind::Plus:
+            case NodeKind::Optional: {
+                info = std::move(infos[n.left]);
+                if (n.kind != NodeKind::Optional) Link(info.last, info.first);
+                if (n.kind != NodeKind::Plus) info.nullable = true;
+                break;
+            }
+        }
+        return info;
+    }
+
+    void Link(const Bits& from, const Bits& to) {
+        for (size_t q = 0; q < follow.size(); ++q) {
+            if (TestBit(from, q)) OrInto(follow[q], to);
+        }
+    }
+
+    const std::vector<Node>& m_nodes;
+    size_t m_words;
+};
+
+size_t CountPositions(const std::vector<Node>& nodes, int root) {
+    std::vector<bool> inside = Subtree(nodes, root);
+    size_t count = 0;
+    for (int i = 0; i <= root; ++i) count += inside[i] && nodes[i].kind == NodeKind::Bytes;
+    return count;
+}
+
+} // namespace
+
+RegexSearcher::RegexSearcher() = default;
+
+bool RegexSearcher::Compile(std::string_view pattern) {
+    m_error.clear();
+    m_words = 0;
+    Flush(m_forward);
+    Flush(m_backward);
+    Flush(m_alive);
+    m_forwardStart = -1;
+    m_forward.built = m_backward.built = 0;
+    m_flushes = 0;
+
+    m_anchorStart = !pattern.empty() && pattern.front() == '^';
+    if (m_anchorStart) pattern.remove_prefix(1);
+    m_anchorEnd = !pattern.empty() && pattern.back() == '$' &&
+                  (pattern.size() < 2 || pattern[pattern.size() - 2] != '\\');
+    if (m_anchorEnd) pattern.remove_suffix(1);
+
+    std::vector<Node> nodes;
+    Parser parser(pattern, nodes);
+    int root = parser.Parse(m_error);
+    if (root < 0) return false;
+    if ((m_anchorStart || m_anchorEnd) && parser.TopLevelAlternation()) {
+        m_error = "^ and $ anchor the whole pattern; group the alternatives, as in ^(a|b)$";
+        return false;
+    }
+    size_t states = CountPositions(nodes, root) + 1;
+    if (states > kMaxPositions) {
+        m_error = "pattern too large";
+        return false;
+    }
+
+    size_t words = (states + 63) / 64;
+    Glushkov automaton(nodes, words);
+    automaton.bytes.push_back(nullptr);
+    automaton.follow.emplace_back(words, 0);
+    Glushkov::Info info = automaton.Build(root);
+    automaton.follow[0] = info.first;
+    if (IsEmpty(info.last)) {
+        m_error = "pattern only matches empty text";
+        return false;
+    }
+
+    // Bytes no state tells apart share a class; a newline always has its
+    // own, since `$` is decided by it
+    std::map<Bits, int> classes;
+    m_reach.clear();
+    for (unsigned c = 0; c < 256; ++c) {
+        Bits signature(words + 1, 0);
+        for (size_t q = 1; q < states; ++q) {
+            if ((*automaton.bytes[q])[c]) SetBit(signature, q);
+        }
+        signature[words] = c == '\n';
+        auto inserted = classes.emplace(signature, static_cast<int>(classes.size()));
+        if (inserted.second) m_reach.emplace_back(signature.begin(), signature.end() - 1);
+        m_class[c] = static_cast<uint8_t>(inserted.first->second);
+    }
+    m_classCount = static_cast<int>(classes.size());
+    m_newlineClass = m_class[static_cast<unsigned char>('\n')];
+
+    m_words = words;
+    m_follow = std::move(automaton.follow);
+    m_accept = info.last;
+    return true;
+}
+
+RegexStats RegexSearcher::Stats() const {
+    RegexStats stats;
+    stats.forwardStates = m_forward.built;
+    stats.backwardStates = m_backward.built;
+    stats.cacheFlushes = m_flushes;
+    stats.cacheBytes = m_forward.bytes + m_backward.bytes + m_alive.bytes;
+    return stats;
+}
+
+int32_t RegexSearcher::Intern(Dfa& dfa, Bits set, uint8_t flags) {
+    std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(uint64_t));
+    auto found = dfa.ids.find(key);
+    if (found != dfa.ids.end()) return found->second;
+
+    int32_t id = static_cast<int32_t>(dfa.sets.size());
+    dfa.bytes += 2 * key.size() + m_classCount * sizeof(int32_t) + 64;
+    dfa.ids.emplace(std::move(key), id);
+    dfa.sets.push_back(std::move(set));
+    dfa.flags.push_back(flags);
+    dfa.next.resize(dfa.next.size() + m_classCount, -1);
+    dfa.built++;
+    return id;
+}
+
+void RegexSearcher::Flush(Dfa& dfa) {
+    if (!dfa.sets.empty()) m_flushes++;
+    dfa.sets.clear();
+    dfa.flags.clear();
+    dfa.next.clear();
+    dfa.ids.clear();
+    dfa.bytes = 0;
+}
+
+bool RegexSearcher::OverLimit(const Dfa& dfa) const {
+    return dfa.bytes > m_cacheLimit / 2;
+}
+
+uint8_t RegexSearcher::ForwardFlags(const Bits& set) const {
+    return Intersects(set, m_accept) ? kAcceptFlag : 0;
+}
+
+uint8_t RegexSearcher::BackwardFlags(const Bits& set) const {
+    return TestBit(set, 0) ? kStartFlag : 0;
+}
+
+int32_t RegexSearcher::BuildForwardStep(int32_t state, int byteClass) {
+    Bits set(m_words, 0);
+    const Bits& from = m_forward.sets[state];
+    for (size_t q = 0; q < m_follow.size(); ++q) {
+        if (TestBit(from, q)) OrInto(set, m_follow[q]);
+    }
+    const Bits& reach = m_reach[byteClass];
+    for (size_t i = 0; i < m_words; ++i) set[i] &= reach[i];
+    uint8_t flags = ForwardFlags(set);
+    int32_t id = Intern(m_forward, std::move(set), flags);
+    m_forward.next[state * m_classCount + byteClass] = id;
+    return id;
+}
+
+int32_t RegexSearcher::BuildBackwardStep(int32_t state, int byteClass) {
+    Bits entered = m_backward.sets[state];
+    const Bits& reach = m_reach[byteClass];
+    for (size_t i = 0; i < m_words; ++i) entered[i] &= reach[i];
+    Bits set(m_words, 0);
+    if (!IsEmpty(entered)) {
+        for (size_t q = 0; q < m_follow.size(); ++q) {
+            if (Intersects(m_follow[q], entered)) SetBit(set, q);
+        }
+    }
+    if (!m_anchorEnd || byteClass == m_newlineClass) OrInto(set, m_accept);
+    uint8_t flags = BackwardFlags(set);
+    int32_t id = Intern(m_backward, std::move(set), flags);
+    m_backward.next[state * m_classCount + byteClass] = id;
+    return id;
+}
+
+int32_t RegexSearcher::BuildAliveStep(int32_t state, int byteClass) {
+    Bits entered = m_alive.sets[state];
+    const Bits& reach = m_reach[byteClass];
+    for (size_t i = 0; i < m_words; ++i) entered[i] &= reach[i];
+    Bits set(m_words, 0);
+    if (!IsEmpty(entered)) {
+        for (size_t q = 0; q < m_follow.size(); ++q) {
+            if (Intersects(m_follow[q], entered)) SetBit(set, q);
+        }
+    }
+    uint8_t flags = BackwardFlags(set);
+    int32_t id = Intern(m_alive, std::move(set), flags);
+    m_alive.next[state * m_classCount + byteClass] = id;
+    return id;
+}
+
+// The backward state at `end`, where no more text may be read
+int32_t RegexSearcher::BackwardEnd(std::string_view text, size_t end) {
+    Bits set(m_words, 0);
+    if (!m_anchorEnd || end == text.size() || text[end] == '\n') set = m_accept;
+    uint8_t flags = BackwardFlags(set);
+    return Intern(m_backward, std::move(set), flags);
+}
+
+void RegexSearcher::FindAll(std::string_view text, const TextRange& range, std::vector<TextRange>& out) {
+    if (m_words == 0) return;
+    m_range = {range.start, std::min(range.end, text.size())};
+    if (m_range.Empty()) return;
+
+    // Backward over the whole range, noting the set at every block start
+    size_t blocks = (m_range.Length() + kBlockBytes - 1) / kBlockBytes;
+    m_checkpoints.assign(blocks + 1, Bits());
+    int32_t state = BackwardEnd(text, m_range.end);
+    m_checkpoints[blocks] = m_backward.sets[state];
+    for (size_t k = blocks; k-- > 0;) {
+        size_t start = m_range.start + k * kBlockBytes;
+        for (size_t p = std::min(start + kBlockBytes, m_range.end); p-- > start;) {
+            state = BackwardStep(state, m_class[static_cast<unsigned char>(text[p])]);
+        }
+        m_checkpoints[k] = m_backward.sets[state];
+        if (OverLimit(m_backward)) {
+            Bits keep = m_backward.sets[state];
+            Flush(m_backward);
+            uint8_t flags = BackwardFlags(keep);
+            state = Intern(m_backward, std::move(keep), flags);
+        }
+    }
+    m_blocks[0].valid = m_blocks[1].valid = false;
+
+    // Forward, starting a match wherever one can start
+    for (size_t p = m_range.start; p < m_range.end;) {
+        BackwardAt(text, p);
+        const Block& block = m_blocks[m_current];
+        const int32_t* ids = block.ids.data() - block.start;
+        size_t stop = std::min(block.end, m_range.end);
+        while (p < stop && !(m_backward.flags[ids[p]] & kStartFlag)) p++;
+        if (p == stop) continue;
+        if (m_anchorStart && p > 0 && text[p - 1] != '\n') {
+            p++;
+            continue;
+        }
+        size_t end = Extend(text, p);
+        if (end > p) out.push_back({p, end});
+        p = std::max(end, p + 1);
+    }
+}
+
+// Backward from range.end over the states that can read on to it, which
+// at range.end is all of them, until none can
+size_t RegexSearcher::Unsettled(std::string_view text, const TextRange& range) {
+    size_t end = std::min(range.end, text.size());
+    if (m_words == 0 || range.start >= end) return end;
+
+    Bits all(m_words, 0);
+    for (size_t q = 0; q < m_follow.size(); ++q) SetBit(all, q);
+    int32_t state = Intern(m_alive, std::move(all), kStartFlag);
+    size_t earliest = end;
+    for (size_t p = end; p-- > range.start;) {
+        state = AliveStep(state, m_class[static_cast<unsigned char>(text[p])]);
+        if (m_alive.flags[state] & kStartFlag) earliest = p;
+        else if (IsEmpty(m_alive.sets[state])) break;
+        if (OverLimit(m_alive)) {
+            Bits keep = m_alive.sets[state];
+            Flush(m_alive);
+            uint8_t flags = BackwardFlags(keep);
+            state = Intern(m_alive, std::move(keep), flags);
+        }
+    }
+    return earliest;
+}
+
+void RegexSearcher::FillBlock(std::string_view text, size_t index, Block& block) {
+    if (OverLimit(m_backward)) {
+        Flush(m_backward);
+        m_blocks[0].valid = m_blocks[1].valid = false;
+    }
+    block.start = m_range.start + index * kBlockBytes;
+    block.end = std::min(block.start + kBlockBytes, m_range.end);
+    block.ids.resize(block.end - block.start + 1);
+
+    Bits set = m_checkpoints[index + 1];
+    uint8_t flags = BackwardFlags(set);
+    int32_t state = Intern(m_backward, std::move(set), flags);
+    block.ids.back() = state;
+    for (size_t p = block.end; p-- > block.start;) {
+        state = BackwardStep(state, m_class[static_cast<unsigned char>(text[p])]);
+        block.ids[p - block.start] = state;
+    }
+    block.valid = true;
+}
+
+// The backward state at pos. The forward pass only moves on, apart from
+// resuming at a match's end after looking one byte past it, so two blocks
+// are kept and the one further back is replaced.
+int32_t RegexSearcher::BackwardAt(std::string_view text, size_t pos) {
+    for (int i : {m_current, 1 - m_current}) {
+        const Block& block = m_blocks[i];
+        if (block.valid && pos >= block.start && (pos < block.end || pos == m_range.end)) {
+            m_current = i;
+            return block.ids[pos - block.start];
+        }
+    }
+    size_t last = m_checkpoints.size() - 2;
+    size_t index = std::min((pos - m_range.start) / kBlockBytes, last);
+    m_current = !m_blocks[0].valid ? 0
+                : !m_blocks[1].valid ? 1
+                : m_blocks[0].start < m_blocks[1].start ? 0 : 1;
+    Block& block = m_blocks[m_current];
+    FillBlock(text, index, block);
+    return block.ids[pos - block.start];
+}
+
+// End of the longest match starting at start, which is known to have one.
+// It stops as soon as no match end is reachable any more, which is right
+// after the last one.
+size_t RegexSearcher::Extend(std::string_view text, size_t start) {
+    if (m_forwardStart < 0) {
+        Bits initial(m_words, 0);
+        SetBit(initial, 0);
+        m_forwardStart = Intern(m_forward, initial, ForwardFlags(initial));
+    }
+    int32_t state = m_forwardStart;
+    size_t end = start;
+    for (size_t p = start;; ++p) {
+        if (!Intersects(m_forward.sets[state], m_backward.sets[BackwardAt(text, p)])) break;
+        if ((m_forward.flags[state] & kAcceptFlag) && p > start &&
+            (!m_anchorEnd || p == text.size() || text[p] == '\n')) {
+            end = p;
+        }
+        if (p == m_range.end) break;
+
+        state = ForwardStep(state, m_class[static_cast<unsigned char>(text[p])]);
+        if (OverLimit(m_forward)) {
+            Bits keep = m_forward.sets[state];
+            Flush(m_forward);
+            m_forwardStart = -1;
+            uint8_t flags = ForwardFlags(keep);
+            state = Intern(m_forward, std::move(keep), flags);
+        }
+    }
+    return end;
+}
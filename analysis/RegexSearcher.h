@@ -0,0 +1,151 @@
+#ifndef GROUP56_WORK_REGEXSEARCHER_H
+#define GROUP56_WORK_REGEXSEARCHER_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "TextRange.h"
+
+// What the searcher's state caches have done since Compile
+struct RegexStats {
+    size_t forwardStates = 0;   // built, flushed ones included
+    size_t backwardStates = 0;
+    size_t cacheFlushes = 0;
+    size_t cacheBytes = 0;      // held now, all caches
+};
+
+// Regular expression find in time linear in the text, for any pattern.
+//
+// Syntax: literals, `.`, `[...]` and `[^...]` (ASCII members, ranges),
+// `\d \w \s` and their negations, `\n \t` and escaped punctuation, `|`,
+// `(...)` and `(?:...)`, `* + ?` and `{m}`, `{m,}`, `{m,n}`. `^` and `$` are
+// line anchors and may only open and close the whole pattern; they anchor
+// all of it, so alternatives at the top level must be grouped, `^(a|b)`
+// rather than `^a|b`, which is refused as it would mean `^a` or `b`. `.` and
+// negated classes match one UTF-8 character; `.` doesn't match a newline.
+// Matches are leftmost-longest, non-empty and don't overlap.
+//
+// The pattern becomes a position (Glushkov) automaton with no empty moves,
+// and two DFAs over sets of its states are built lazily as the text needs
+// them. A backward pass works out, for every position, the states from
+// which the rest of the text still reaches a match end. The forward pass
+// then starts a match wherever the start state is in that set, and extends
+// it only while its states intersect the set, so it stops one byte past
+// the longest end instead of running on to where the DFA dies. Each byte
+// is read twice backwards and once forwards. The backward sets are kept
+// per position only for a block at a time, with checkpoints between
+// blocks.
+//
+// Each DFA's states and transitions live in a cache of bounded size that
+// is thrown away when full, as in RE2; the states in use are rebuilt.
+class RegexSearcher {
+public:
+    RegexSearcher();
+
+    // False, with Error() saying why, if the pattern isn't supported
+    bool Compile(std::string_view pattern);
+    const std::string& Error() const { return m_error; }
+
+    // Bytes the two state caches may hold between them, half each
+    void SetCacheLimit(size_t bytes) { m_cacheLimit = bytes; }
+
+    // Appends the matches lying in text[range.start, range.end). A `$` is
+    // satisfied at a line end or the end of text, not at range.end.
+    void FindAll(std::string_view text, const TextRange& range, std::vector<TextRange>& out);
+
+    // Where the earliest match attempt still going at range.end started, or
+    // range.end if none is: of the matches FindAll finds in the range, those
+    // starting before this are the ones a search running on past range.end
+    // would find too. Attempts that `^` would turn away count as well.
+    size_t Unsettled(std::string_view text, const TextRange& range);
+
+    RegexStats Stats() const;
+
+private:
+    using Bits = std::vector<uint64_t>;  // a set of automaton states
+
+    // A DFA over sets of automaton states. States are numbered in the order
+    // they are built; `next` holds -1 for a transition not yet worked out.
+    struct Dfa {
+        std::vector<Bits> sets;
+        std::vector<uint8_t> flags;  // kStartFlag, kAcceptFlag
+        std::vector<int32_t> next;   // [state * class count + byte class]
+        std::unordered_map<std::string, int32_t> ids;
+        size_t bytes = 0;
+        size_t built = 0;
+    };
+
+    static constexpr uint8_t kStartFlag = 1;   // backward: a match starts here
+    static constexpr uint8_t kAcceptFlag = 2;  // forward: a match may end here
+
+    // Backward sets are kept per position for this many positions at a time
+    static constexpr size_t kBlockBytes = 16 << 10;
+
+    struct Block {
+        size_t start = 0;
+        size_t end = 0;            // inclusive: the next block's first position
+        std::vector<int32_t> ids;  // backward state at each position
+        bool valid = false;
+    };
+
+    int32_t Intern(Dfa& dfa, Bits set, uint8_t flags);
+    void Flush(Dfa& dfa);
+    bool OverLimit(const Dfa& dfa) const;
+    uint8_t ForwardFlags(const Bits& set) const;
+    uint8_t BackwardFlags(const Bits& set) const;
+    // The states entered from `state` by a byte of the class
+    int32_t ForwardStep(int32_t state, int byteClass) {
+        int32_t next = m_forward.next[state * m_classCount + byteClass];
+        return next >= 0 ? next : BuildForwardStep(state, byteClass);
+    }
+    // The states that reach a match end from the position before a byte of
+    // the class, given `state` holds those that do from the position after it
+    int32_t BackwardStep(int32_t state, int byteClass) {
+        int32_t next = m_backward.next[state * m_classCount + byteClass];
+        return next >= 0 ? next : BuildBackwardStep(state, byteClass);
+    }
+    // As BackwardStep, but for the states that can read on to the range end
+    int32_t AliveStep(int32_t state, int byteClass) {
+        int32_t next = m_alive.next[state * m_classCount + byteClass];
+        return next >= 0 ? next : BuildAliveStep(state, byteClass);
+    }
+    int32_t BuildForwardStep(int32_t state, int byteClass);
+    int32_t BuildBackwardStep(int32_t state, int byteClass);
+    int32_t BuildAliveStep(int32_t state, int byteClass);
+    int32_t BackwardEnd(std::string_view text, size_t end);
+
+    void FillBlock(std::string_view text, size_t index, Block& block);
+    int32_t BackwardAt(std::string_view text, size_t pos);
+    size_t Extend(std::string_view text, size_t start);
+
+    std::string m_error;
+    size_t m_cacheLimit = 8 << 20;
+
+    // The automaton: state 0 starts, states 1.. are the pattern's byte
+    // positions. m_reach[c] is the positions accepting bytes of class c.
+    size_t m_words = 0;
+    int m_classCount = 0;
+    uint8_t m_class[256] = {};
+    int m_newlineClass = 0;
+    std::vector<Bits> m_follow;
+    std::vector<Bits> m_reach;
+    Bits m_accept;
+    bool m_anchorStart = false;
+    bool m_anchorEnd = false;
+
+    Dfa m_forward;
+    Dfa m_backward;
+    Dfa m_alive;  // for Unsettled, bounded like the other two
+    int32_t m_forwardStart = -1;
+    size_t m_flushes = 0;
+
+    // The pass in progress
+    TextRange m_range;
+    std::vector<Bits> m_checkpoints;  // backward set at each block's start, then at range.end
+    Block m_blocks[2];
+    int m_current = 0;  // the block last read from
+};
+
+#endif //GROUP56_WORK_REGEXSEARCHER_H
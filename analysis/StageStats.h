@@ -0,0 +1,33 @@
+#ifndef GROUP56_WORK_STAGESTATS_H
+#define GROUP56_WORK_STAGESTATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// How often one stage of an event pipeline ran, was skipped because none
+// of its inputs changed, and what it cost
+struct StageStats {
+    const char* name = "";
+    uint64_t runs = 0;
+    uint64_t skips = 0;
+    std::chrono::nanoseconds time{0};
+    std::chrono::nanoseconds worst{0};
+
+    void Add(std::chrono::nanoseconds elapsed) {
+        runs++;
+        time += elapsed;
+        worst = std::max(worst, elapsed);
+    }
+};
+
+// UI-thread cost of the editor's UPDATEUI handling, per update and per stage
+struct UiUpdateStats {
+    uint64_t updates = 0;
+    std::chrono::nanoseconds time{0};
+    std::chrono::nanoseconds worst{0};
+    std::vector<StageStats> stages;
+};
+
+#endif //GROUP56_WORK_STAGESTATS_H
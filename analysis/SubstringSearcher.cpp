@@ -0,0 +1,114 @@
+#include "SubstringSearcher.h"
+
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define GROUP56_SEARCH_X86 1
+#endif
+
+namespace {
+
+// First start in [p, end - n] where needle[0, n) occurs, or nullptr; n >= 2
+using Kernel = const char* (*)(const char* p, const char* end, const char* needle, size_t n);
+
+const char* FindScalar(const char* p, const char* end, const char* needle, size_t n) {
+    while (static_cast<size_t>(end - p) >= n) {
+        p = static_cast<const char*>(std::memchr(p, needle[0], end - p - n + 1));
+        if (!p) return nullptr;
+        if (p[n - 1] == needle[n - 1] && std::memcmp(p + 1, needle + 1, n - 2) == 0) return p;
+        p++;
+    }
+    return nullptr;
+}
+
+#ifdef GROUP56_SEARCH_X86
+
+// Bit i of mask is set where p + i starts with the needle's first and last
+// byte; those are checked in full
+inline const char* CheckCandidates(unsigned mask, const char* p, const char* needle, size_t n) {
+    while (mask) {
+        unsigned bit = __builtin_ctz(mask);
+        if (std::memcmp(p + bit + 1, needle + 1, n - 2) == 0) return p + bit;
+        mask &= mask - 1;
+    }
+    return nullptr;
+}
+
+const char* FindSse2(const char* p, const char* end, const char* needle, size_t n) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[n - 1]);
+    for (; static_cast<size_t>(end - p) >= 16 + n - 1; p += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + n - 1));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        if (const char* hit = CheckCandidates(mask, p, needle, n)) return hit;
+    }
+    return FindScalar(p, end, needle, n);
+}
+
+__attribute__((target("avx2")))
+const char* FindAvx2(const char* p, const char* end, const char* needle, size_t n) {
+    const __m256i first = _mm256_set1_epi8(needle[0]);
+    const __m256i last = _mm256_set1_epi8(needle[n - 1]);
+    for (; static_cast<size_t>(end - p) >= 32 + n - 1; p += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + n - 1));
+        unsigned mask = static_cast<unsigned>(
+                _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last))));
+        if (const char* hit = CheckCandidates(mask, p, needle, n)) return hit;
+    }
+    return FindSse2(p, end, needle, n);
+}
+
+#endif
+
+struct KernelChoice {
+    Kernel kernel;
+    const char* name;
+};
+
+const KernelChoice& ChosenKernel() {
+    static const KernelChoice choice = [] {
+#ifdef GROUP56_SEARCH_X86
+        if (__builtin_cpu_supports("avx2")) return KernelChoice{FindAvx2, "avx2"};
+        return KernelChoice{FindSse2, "sse2"};
+#else
+        return KernelChoice{FindScalar, "scalar"};
+#endif
+    }();
+    return choice;
+}
+
+} // namespace
+
+SubstringSearcher::SubstringSearcher(std::string needle) : m_needle(std::move(needle)) {}
+
+const char* SubstringSearcher::KernelName() {
+    return ChosenKernel().name;
+}
+
+size_t SubstringSearcher::Find(std::string_view text, size_t from) const {
+    const size_t n = m_needle.size();
+    if (n == 0 || from > text.size() || text.size() - from < n) return npos;
+
+    const char* begin = text.data();
+    const char* hit;
+    if (n == 1) {
+        hit = static_cast<const char*>(std::memchr(begin + from, m_needle[0], text.size() - from));
+    } else {
+        hit = ChosenKernel().kernel(begin + from, begin + text.size(), m_needle.data(), n);
+    }
+    return hit ? hit - begin : npos;
+}
+
+size_t SubstringSearcher::FindBatch(std::string_view text, size_t from, size_t limit,
+                                    std::vector<size_t>& out) const {
+    for (size_t found = 0; found < limit; ++found) {
+        size_t hit = Find(text, from);
+        if (hit == npos) return text.size();
+        out.push_back(hit);
+        from = hit + m_needle.size();
+    }
+    return from;
+}
@@ -0,0 +1,40 @@
+#ifndef GROUP56_WORK_SUBSTRINGSEARCHER_H
+#define GROUP56_WORK_SUBSTRINGSEARCHER_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Finds a fixed byte string in a buffer, left to right, without copying it.
+//
+// Candidates are found a vector at a time by comparing the first and the
+// last byte of the needle against two loads `length - 1` bytes apart; only
+// positions where both agree are compared in full. On typical text the two
+// bytes together rule out nearly every position, so the scan runs close to
+// memory speed. The widest kernel the CPU has is picked once: AVX2, then
+// SSE2 on any x86-64, else a memchr-based loop.
+class SubstringSearcher {
+public:
+    static constexpr size_t npos = std::string_view::npos;
+
+    explicit SubstringSearcher(std::string needle);
+
+    const std::string& Needle() const { return m_needle; }
+
+    // Start of the first occurrence at or after `from`, or npos
+    size_t Find(std::string_view text, size_t from = 0) const;
+
+    // Appends the starts of up to `limit` non-overlapping occurrences at or
+    // after `from` and returns where the next batch resumes: just past the
+    // last one found, or text.size() once the text is exhausted
+    size_t FindBatch(std::string_view text, size_t from, size_t limit, std::vector<size_t>& out) const;
+
+    // "avx2", "sse2" or "scalar"
+    static const char* KernelName();
+
+private:
+    std::string m_needle;
+};
+
+#endif //GROUP56_WORK_SUBSTRINGSEARCHER_H
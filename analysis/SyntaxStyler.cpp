@@ -0,0 +1,55 @@
+#include "SyntaxStyler.h"
+
+#include <algorithm>
+
+namespace {
+
+SyntaxStyle CommentStyle(std::string_view text) {
+    if (text.substr(0, 3) == "/**" || text.substr(0, 3) == "/*!") return SyntaxStyle::DocComment;
+    if (text.substr(0, 2) == "//") return SyntaxStyle::LineComment;
+    return SyntaxStyle::Comment;
+}
+
+} // namespace
+
+void SyntaxStyler::SetKeywords(int set, std::string_view words) {
+    auto& keywords = m_keywords[set];
+    keywords.clear();
+    size_t pos = 0;
+    while (pos < words.size()) {
+        size_t stop = words.find(' ', pos);
+        if (stop == std::string_view::npos) stop = words.size();
+        if (stop > pos) keywords.emplace(words.substr(pos, stop - pos));
+        pos = stop + 1;
+    }
+}
+
+LexState SyntaxStyler::StyleLine(std::string_view text, size_t begin, size_t end, LexState state,
+                                 std::vector<uint8_t>& styles) const {
+    m_tokens.clear();
+    state = LexLine(text, begin, end, 0, state, m_tokens);
+
+    size_t base = styles.size();
+    styles.resize(base + (end - begin), static_cast<uint8_t>(SyntaxStyle::Default));
+    for (const Token& token : m_tokens) {
+        std::string_view word = TokenText(text, token);
+        SyntaxStyle style = SyntaxStyle::Default;
+        switch (token.kind) {
+            case TokenKind::Identifier:
+                style = m_keywords[0].count(word) ? SyntaxStyle::Keyword
+                      : m_keywords[1].count(word) ? SyntaxStyle::Keyword2
+                      : SyntaxStyle::Identifier;
+                break;
+            case TokenKind::Number: style = SyntaxStyle::Number; break;
+            case TokenKind::String:
+                style = (token.flags & kTokenUnterminated) ? SyntaxStyle::UnterminatedString : SyntaxStyle::String;
+                break;
+            case TokenKind::Character: style = SyntaxStyle::Character; break;
+            case TokenKind::Comment: style = CommentStyle(word); break;
+            case TokenKind::Preprocessor: style = SyntaxStyle::Preprocessor; break;
+            case TokenKind::Punctuation: style = SyntaxStyle::Operator; break;
+        }
+        std::fill_n(styles.begin() + base + (token.offset - begin), token.length, static_cast<uint8_t>(style));
+    }
+    return state;
+}
@@ -0,0 +1,55 @@
+#ifndef GROUP56_WORK_SYNTAXSTYLER_H
+#define GROUP56_WORK_SYNTAXSTYLER_H
+
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Lexer.h"
+
+// What a byte of the document is, for colouring. The editor maps these to
+// its Scintilla styles.
+enum class SyntaxStyle : uint8_t {
+    Default,  // whitespace
+    Keyword,
+    Keyword2,
+    Identifier,
+    Number,
+    String,
+    UnterminatedString,
+    Character,
+    Comment,
+    LineComment,
+    DocComment,
+    Preprocessor,
+    Operator,
+    Count
+};
+
+// How much work styling requests caused
+struct StylingStats {
+    uint64_t passes = 0;        // style-needed notifications handled
+    uint64_t linesStyled = 0;
+    uint64_t linesSkipped = 0;  // known to keep their styling after an edit
+};
+
+// Styles the document a line at a time on top of LexLine. The state at the
+// end of each line is returned so the caller can store it and later resume
+// from any line, and stop once a line ends in the same state as before.
+class SyntaxStyler {
+public:
+    // Space-separated words styled Keyword (set 0) or Keyword2 (set 1)
+    void SetKeywords(int set, std::string_view words);
+
+    // Appends one SyntaxStyle per byte of the line text[begin, end)
+    LexState StyleLine(std::string_view text, size_t begin, size_t end, LexState state,
+                       std::vector<uint8_t>& styles) const;
+
+private:
+    std::set<std::string, std::less<>> m_keywords[2];
+    mutable std::vector<Token> m_tokens;  // reused between lines
+};
+
+#endif //GROUP56_WORK_SYNTAXSTYLER_H
@@ -0,0 +1,16 @@
+#ifndef GROUP56_WORK_TEXTRANGE_H
+#define GROUP56_WORK_TEXTRANGE_H
+
+#include <cstddef>
+
+// Half-open byte range [start, end) in document coordinates
+struct TextRange {
+    size_t start = 0;
+    size_t end = 0;
+
+    size_t Length() const { return end > start ? end - start : 0; }
+    bool Empty() const { return end <= start; }
+    bool Contains(size_t pos) const { return pos >= start && pos < end; }
+};
+
+#endif //GROUP56_WORK_TEXTRANGE_H
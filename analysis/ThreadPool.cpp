@@ -0,0 +1,79 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threads) {
+    Start(threads);
+}
+
+ThreadPool::~ThreadPool() {
+    Stop();
+}
+
+ThreadPool& ThreadPool::Shared() {
+    static ThreadPool pool;
+    return pool;
+}
+
+void ThreadPool::Resize(size_t threads) {
+    Stop();
+    Start(threads);
+}
+
+void ThreadPool::Start(size_t threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    m_stopping = false;
+    for (size_t i = 1; i < threads; ++i) m_workers.emplace_back(&ThreadPool::Work, this);
+}
+
+void ThreadPool::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& worker : m_workers) worker.join();
+    m_workers.clear();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& task) {
+    std::unique_lock<std::mutex> batch(m_batchMutex, std::try_to_lock);
+    if (m_workers.empty() || count <= 1 || !batch.owns_lock()) {
+        for (size_t i = 0; i < count; ++i) task(i);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_count = count;
+    m_next = 0;
+    m_finished = 0;
+    m_batch++;
+    m_wake.notify_all();
+
+    Drain(lock);
+    m_done.wait(lock, [&] { return m_finished == m_count; });
+    m_task = nullptr;
+}
+
+void ThreadPool::Work() {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_wake.wait(lock, [&] { return m_stopping || m_batch != seen; });
+        if (m_stopping) return;
+        seen = m_batch;
+        Drain(lock);
+    }
+}
+
+void ThreadPool::Drain(std::unique_lock<std::mutex>& lock) {
+    while (m_task && m_next < m_count) {
+        size_t index = m_next++;
+        const std::function<void(size_t)>& task = *m_task;
+        lock.unlock();
+        task(index);
+        lock.lock();
+        if (++m_finished == m_count) m_done.notify_all();
+    }
+}
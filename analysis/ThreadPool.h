@@ -0,0 +1,64 @@
+#ifndef GROUP56_WORK_THREADPOOL_H
+#define GROUP56_WORK_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of threads for splitting one job into independent tasks. The
+// calling thread takes part, so a pool of size 1 has no threads of its own
+// and runs everything inline.
+//
+// One pool is meant to be shared, e.g. by the analyzers of all open
+// documents: only one document is normally being analysed at a time, and a
+// pool per document would keep a full set of threads parked for each.
+class ThreadPool {
+public:
+    // 0 means one thread per hardware thread
+    explicit ThreadPool(size_t threads = 0);
+    ~ThreadPool();
+
+    // The process-wide pool, one thread per hardware thread, started on
+    // first use
+    static ThreadPool& Shared();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Threads working on a ParallelFor, the caller included
+    size_t Size() const { return m_workers.size() + 1; }
+    // Only while no ParallelFor is running
+    void Resize(size_t threads);
+
+    // Runs task(0) ... task(count - 1), in any order and on any of the
+    // threads, and returns once all of them are done. A call made while
+    // another thread's batch is running doesn't wait for it but runs its
+    // tasks on the calling thread alone. Tasks must not call it.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& task);
+
+private:
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_batchMutex;  // held by the thread whose batch the workers are on
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const std::function<void(size_t)>* m_task = nullptr;
+    size_t m_count = 0;
+    size_t m_next = 0;      // next task index to hand out
+    size_t m_finished = 0;  // tasks completed
+    uint64_t m_batch = 0;   // bumped for every ParallelFor
+    bool m_stopping = false;
+
+    void Start(size_t threads);
+    void Stop();
+    void Work();
+    // Runs tasks of the current batch until none are left; called with the lock held
+    void Drain(std::unique_lock<std::mutex>& lock);
+};
+
+#endif //GROUP56_WORK_THREADPOOL_H
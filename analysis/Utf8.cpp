@@ -0,0 +1,109 @@
+#include "Utf8.h"
+
+#include <bitset>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define GROUP56_UTF8_SSE2 1
+#endif
+
+namespace {
+
+// Length of the ASCII run starting at text[i]
+size_t AsciiRun(const unsigned char* p, size_t i, size_t n) {
+    size_t start = i;
+#ifdef GROUP56_UTF8_SSE2
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        if (_mm_movemask_epi8(chunk) != 0) break;
+    }
+#else
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        if (word & 0x8080808080808080ull) break;
+    }
+#endif
+    while (i < n && p[i] < 0x80) ++i;
+    return i - start;
+}
+
+// Length of the well-formed multi-byte sequence at p[i], or 0
+size_t SequenceLength(const unsigned char* p, size_t i, size_t n) {
+    unsigned char lead = p[i];
+    size_t length;
+    uint32_t codePoint;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codePoint = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        codePoint = lead & 0x0F;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        length = 4;
+        codePoint = lead & 0x07;
+    } else {
+        return 0;  // continuation byte, C0/C1 overlong lead, or F5..FF
+    }
+    if (i + length > n) return 0;
+
+    for (size_t k = 1; k < length; ++k) {
+        if ((p[i + k] & 0xC0) != 0x80) return 0;
+        codePoint = (codePoint << 6) | (p[i + k] & 0x3F);
+    }
+    if (length == 3 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) return 0;
+    if (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF)) return 0;
+    return length;
+}
+
+} // namespace
+
+size_t FindInvalidUtf8(std::string_view text) {
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    size_t i = 0;
+    while (i < n) {
+        i += AsciiRun(p, i, n);
+        if (i == n) break;
+        size_t length = SequenceLength(p, i, n);
+        if (length == 0) return i;
+        i += length;
+    }
+    return std::string_view::npos;
+}
+
+size_t CountCodePoints(std::string_view text) {
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    size_t count = 0;
+    size_t i = 0;
+#ifdef GROUP56_UTF8_SSE2
+    // Continuation bytes are 0x80..0xBF, i.e. below -64 as signed bytes
+    const __m128i threshold = _mm_set1_epi8(-65);
+    for (; i + 16 <= n; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        int leads = _mm_movemask_epi8(_mm_cmpgt_epi8(chunk, threshold));
+        count += std::bitset<16>(static_cast<unsigned>(leads)).count();
+    }
+#endif
+    for (; i < n; ++i) {
+        if ((p[i] & 0xC0) != 0x80) count++;
+    }
+    return count;
+}
+
+std::string Latin1ToUtf8(std::string_view text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 8);
+    for (unsigned char c : text) {
+        if (c < 0x80) {
+            out += static_cast<char>(c);
+        } else {
+            out += static_cast<char>(0xC0 | (c >> 6));
+            out += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+    return out;
+}
@@ -0,0 +1,35 @@
+#ifndef GROUP56_WORK_UTF8_H
+#define GROUP56_WORK_UTF8_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// UTF-8 helpers for the raw document bytes. Scintilla positions are byte
+// offsets into UTF-8, so the analysis code works on bytes throughout and
+// only needs these at the edges: checking a file before handing its bytes
+// over as-is, and turning byte offsets into user-facing columns.
+
+// Offset of the first byte that doesn't start a well-formed sequence
+// (overlongs, surrogates and code points past U+10FFFF included), or npos.
+// Runs of ASCII are skipped 16 bytes at a time.
+size_t FindInvalidUtf8(std::string_view text);
+
+inline bool IsValidUtf8(std::string_view text) {
+    return FindInvalidUtf8(text) == std::string_view::npos;
+}
+
+// Number of code points in valid UTF-8 text (bytes that aren't continuations)
+size_t CountCodePoints(std::string_view text);
+
+// Start of the character holding the byte at pos (pos itself at the end of
+// the text), for cutting valid UTF-8 without splitting a character
+inline size_t CharStart(std::string_view text, size_t pos) {
+    while (pos > 0 && pos < text.size() && (static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80) pos--;
+    return pos;
+}
+
+// Reinterprets Latin-1 bytes as UTF-8, for files that aren't valid UTF-8
+std::string Latin1ToUtf8(std::string_view text);
+
+#endif //GROUP56_WORK_UTF8_H
@@ -0,0 +1,56 @@
+#include "VariableMatcher.h"
+
+#include <algorithm>
+
+VariableMatcher::VariableMatcher() {
+    uint8_t next = 1;
+    for (int c = 0; c < 256; ++c) {
+        if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_') {
+            m_class[c] = next++;
+        }
+    }
+    Build({});
+}
+
+void VariableMatcher::Build(const std::set<std::string>& names) {
+    // Dead and root states; word bytes leave both for the dead state
+    m_next.assign(2 * kClasses, kDead);
+    m_accept.assign(2, 0);
+
+    for (const auto& name : names) {
+        uint32_t state = kRoot;
+        for (unsigned char c : name) {
+            uint8_t cls = m_class[c];
+            if (cls == 0) break;  // not an identifier; can never match
+            uint32_t& slot = m_next[state * kClasses + cls];
+            if (slot == kDead) {
+                slot = static_cast<uint32_t>(m_accept.size());
+                m_accept.push_back(0);
+                m_next.resize(m_next.size() + kClasses, kDead);
+            }
+            state = m_next[state * kClasses + cls];
+        }
+        if (state != kRoot) m_accept[state] = 1;
+    }
+}
+
+void VariableMatcher::FindAll(std::string_view text, const TextRange& range, std::vector<TextRange>& out) const {
+    size_t end = std::min(range.end, text.size());
+    size_t begin = std::min(range.start, end);
+    const auto* bytes = reinterpret_cast<const unsigned char*>(text.data());
+
+    // A range starting mid-word can't match until the next boundary
+    uint32_t state = begin > 0 && m_class[bytes[begin - 1]] ? kDead : kRoot;
+    size_t wordStart = begin;
+    for (size_t i = begin; i < end; ++i) {
+        uint8_t cls = m_class[bytes[i]];
+        if (cls == 0) {
+            if (m_accept[state]) out.push_back({wordStart, i});
+            state = kRoot;
+            wordStart = i + 1;
+        } else {
+            state = m_next[state * kClasses + cls];
+        }
+    }
+    if (m_accept[state] && (end == text.size() || m_class[bytes[end]] == 0)) out.push_back({wordStart, end});
+}
@@ -0,0 +1,43 @@
+#ifndef GROUP56_WORK_VARIABLEMATCHER_H
+#define GROUP56_WORK_VARIABLEMATCHER_H
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TextRange.h"
+
+// Finds every whole-identifier occurrence of a set of names in one pass.
+//
+// This is an Aho-Corasick automaton over identifier bytes specialised for
+// matches that must start and end on an identifier boundary. A match can
+// only begin at the start of a word, so every failure link would lead to a
+// "rest of this word can't match" state, and that is the only one kept. The
+// result is a trie stored as a dense transition table plus a dead state.
+// Any non-identifier byte goes back to the root. Each byte costs one table
+// lookup however many names there are.
+class VariableMatcher {
+public:
+    VariableMatcher();
+
+    // Rebuilds the automaton for `names`
+    void Build(const std::set<std::string>& names);
+
+    // Appends the occurrences lying in text[range.start, range.end)
+    void FindAll(std::string_view text, const TextRange& range, std::vector<TextRange>& out) const;
+
+    size_t StateCount() const { return m_accept.size(); }
+
+private:
+    static constexpr int kClasses = 64;  // 0 for non-identifier bytes, then [A-Za-z0-9_]
+    static constexpr uint32_t kDead = 0;
+    static constexpr uint32_t kRoot = 1;
+
+    std::array<uint8_t, 256> m_class{};
+    std::vector<uint32_t> m_next;   // m_next[state * kClasses + class]
+    std::vector<uint8_t> m_accept;  // whether a name ends in this state
+};
+
+#endif //GROUP56_WORK_VARIABLEMATCHER_H
@@ -0,0 +1,45 @@
+#ifndef GROUP56_WORK_BENCH_H
+#define GROUP56_WORK_BENCH_H
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+// Shared helpers for the micro-benchmarks in Group56_bench
+
+// Synthetic C++-like source of roughly `bytes` bytes: declarations, calls,
+// output statements and comments, deterministic for a given seed
+std::string MakeCorpus(size_t bytes, unsigned seed = 56);
+
+// Best-of-`repeats` wall time of fn(), in seconds
+template <typename Fn>
+double TimeBest(int repeats, Fn&& fn) {
+    double best = 1e300;
+    for (int i = 0; i < repeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed.count() < best) best = elapsed.count();
+    }
+    return best;
+}
+
+inline double MegabytesPerSecond(size_t bytes, double seconds) {
+    return seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0;
+}
+
+void RunDeclarationBench();
+void RunIncrementalFindBench();
+void RunLintBench();
+void RunLongLineBench();
+void RunParallelBench();
+void RunRegexBench();
+void RunReplaceBench();
+void RunSearchBench();
+
+// Throughput and latency of each analysis pass on corpora of 1 KB up to
+// maxBytes, as a table and, unless jsonPath is empty, as JSON written
+// there. False if the JSON couldn't be written.
+bool RunPassBench(size_t maxBytes, const std::string& jsonPath);
+
+#endif //GROUP56_WORK_BENCH_H
@@ -0,0 +1,64 @@
+#include "Bench.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+std::string MakeCorpus(size_t bytes, unsigned seed) {
+    static const char* lines[] = {
+            "int count = 0;\n",
+            "double ratio = total / count, scale = 2.5;\n",
+            "string name = \"group56\";\n",
+            "bool ready;\n",
+            "float x, y = 1.0f, z;\n",
+            "result = compute(count, ratio);\n",
+            "std::cout << name << std::endl;\n",
+            "// keep the cursor in view while typing\n",
+            "for (int i = 0; i < count; i++) {\n",
+            "    total += values[i] * scale;\n",
+            "}\n",
+            "if (ready && name.size() > 0) return 0;\n",
+            "\n",
+    };
+    const size_t lineCount = sizeof(lines) / sizeof(lines[0]);
+
+    std::mt19937 rng(seed);
+    std::string text;
+    text.reserve(bytes + 64);
+    while (text.size() < bytes) text += lines[rng() % lineCount];
+    return text;
+}
+
+// Group56_bench [--passes] [--json FILE] [--max-bytes N]
+//   --passes     run only the per-pass benchmark
+//   --json FILE  also write the per-pass results to FILE as JSON
+//   --max-bytes  largest corpus for the per-pass benchmark (500 MB)
+int main(int argc, char** argv) {
+    bool passesOnly = false;
+    std::string jsonPath;
+    size_t maxBytes = size_t(500) << 20;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--passes") == 0) {
+            passesOnly = true;
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--max-bytes") == 0 && i + 1 < argc) {
+            maxBytes = std::strtoull(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "usage: %s [--passes] [--json FILE] [--max-bytes N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!passesOnly) {
+        RunDeclarationBench();
+        RunLintBench();
+        RunLongLineBench();
+        RunParallelBench();
+        RunRegexBench();
+        RunSearchBench();
+        RunIncrementalFindBench();
+        RunReplaceBench();
+    }
+    return RunPassBench(maxBytes, jsonPath) ? 0 : 1;
+}
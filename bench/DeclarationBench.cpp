@@ -0,0 +1,25 @@
+#include "Bench.h"
+
+#include "bench/RegexDeclarations.h"
+
+void RunDeclarationBench() {
+    printf("== Declaration scan (ScanDeclarations) ==\n");
+    printf("%10s %14s %14s %14s %9s\n", "size", "regex MB/s", "lexer MB/s", "scanner MB/s", "speedup");
+
+    for (size_t size : {64u << 10, 1u << 20, 8u << 20}) {
+        std::string text = MakeCorpus(size);
+
+        std::vector<Declaration> expected, actual;
+        double regexTime = TimeBest(3, [&] { expected = ScanDeclarationsRegex(text, 0, text.size()); });
+        double lexTime = TimeBest(3, [&] { Tokenize(text); });
+        double scanTime = TimeBest(3, [&] { actual = ScanDeclarations(text); });
+
+        if (!SameDeclarations(expected, actual)) {
+            printf("%10zu results differ from the regex reference\n", text.size());
+            continue;
+        }
+        printf("%10zu %14.1f %14.1f %14.1f %8.1fx\n", text.size(),
+               MegabytesPerSecond(text.size(), regexTime), MegabytesPerSecond(text.size(), lexTime),
+               MegabytesPerSecond(text.size(), scanTime), regexTime / scanTime);
+    }
+}
@@ -0,0 +1,129 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include "analysis/ErrorRules.h"
+
+namespace {
+
+bool IsStatementKeyword(std::string_view word) {
+    return word == "return" || word == "int" || word == "float" || word == "double" ||
+           word == "bool" || word == "string";
+}
+
+bool IsScopePunctuation(std::string_view text, const Token& token) {
+    return IsPunctuation(text, token, ';') || IsPunctuation(text, token, '{') || IsPunctuation(text, token, '}');
+}
+
+// The per-check loops the rule table replaced, kept as the reference: one
+// pass for missing semicolons and one testing the other four checks at
+// every token
+void CollectErrorsByCheck(std::string_view text, const std::vector<Token>& tokens, bool namespaceStd,
+                          std::vector<TextRange>& out) {
+    const size_t n = tokens.size();
+
+    for (size_t i = 0; i < n;) {
+        uint32_t line = tokens[i].line;
+        size_t candidate = n;
+        for (; i < n && tokens[i].line == line; ++i) {
+            if (IsScopePunctuation(text, tokens[i])) {
+                candidate = n;
+            } else if (candidate == n && tokens[i].kind == TokenKind::Identifier &&
+                       IsStatementKeyword(TokenText(text, tokens[i]))) {
+                candidate = i;
+            }
+        }
+        if (candidate < n) {
+            size_t nl = text.find('\n', tokens[candidate].End());
+            if (nl != std::string::npos) out.push_back({tokens[candidate].offset, nl + 1});
+        }
+    }
+
+    for (size_t i = 0; i < n; ++i) {
+        const Token& token = tokens[i];
+        if (token.kind == TokenKind::String && (token.flags & kTokenUnterminated)) {
+            out.push_back({token.offset, token.offset + 1});
+        }
+        if (token.kind != TokenKind::Identifier) continue;
+
+        if (i + 2 < n && IsWord(text, token, "cout") && IsPunctuation(text, tokens[i + 1], '>') &&
+            IsPunctuation(text, tokens[i + 2], '>') && tokens[i + 2].offset == tokens[i + 1].End()) {
+            out.push_back({token.offset, tokens[i + 2].End()});
+        }
+        if (i + 1 < n && IsWord(text, token, "return") && tokens[i + 1].kind == TokenKind::Number &&
+            TokenText(text, tokens[i + 1]) == "0" && tokens[i + 1].offset > token.End() &&
+            (i + 2 == n || tokens[i + 2].line > tokens[i + 1].line)) {
+            size_t nl = text.find('\n', tokens[i + 1].End());
+            if (nl != std::string::npos) out.push_back({token.offset, nl + 1});
+        }
+        if (!namespaceStd && i + 2 < n && IsWord(text, token, "std") &&
+            IsPunctuation(text, tokens[i + 1], ':') && tokens[i + 1].offset == token.End() &&
+            IsPunctuation(text, tokens[i + 2], ':') && tokens[i + 2].offset == token.End() + 1) {
+            out.push_back({token.offset, tokens[i + 2].End()});
+        }
+    }
+}
+
+// MakeCorpus with a line carrying one of the errors after every 32nd line
+std::string MakeErrorCorpus(size_t bytes) {
+    static const char* errors[] = {
+            "int total = count\n",
+            "std::cout >> name;\n",
+            "    return 0\n",
+            "string label = \"unterminated;\n",
+    };
+    std::string clean = MakeCorpus(bytes);
+    std::string text;
+    text.reserve(clean.size() + clean.size() / 16);
+    size_t lines = 0;
+    for (size_t pos = 0; pos < clean.size();) {
+        size_t stop = clean.find('\n', pos) + 1;
+        text.append(clean, pos, stop - pos);
+        pos = stop;
+        if (++lines % 32 == 0) text += errors[(lines / 32) % 4];
+    }
+    return text;
+}
+
+void SortRanges(std::vector<TextRange>& ranges) {
+    std::sort(ranges.begin(), ranges.end(), [](const TextRange& a, const TextRange& b) {
+        return a.start != b.start ? a.start < b.start : a.end < b.end;
+    });
+}
+
+} // namespace
+
+void RunLintBench() {
+    printf("\n== Error rules (HighlightErrors), on pre-lexed tokens ==\n");
+    printf("%10s %14s %14s %9s %8s\n", "size", "checks MB/s", "engine MB/s", "speedup", "errors");
+
+    LintEngine engine(ErrorRules());
+    for (size_t size : {64u << 10, 1u << 20, 8u << 20}) {
+        std::string text = MakeErrorCorpus(size);
+        std::vector<Token> tokens = Tokenize(text);
+
+        std::vector<TextRange> expected, actual;
+        LintStats stats;
+        double checkTime = TimeBest(3, [&] {
+            expected.clear();
+            CollectErrorsByCheck(text, tokens, false, expected);
+        });
+        double engineTime = TimeBest(3, [&] {
+            actual.clear();
+            engine.Run(text, tokens, tokens.size(), 0, actual, stats);
+        });
+
+        SortRanges(expected);
+        SortRanges(actual);
+        bool same = expected.size() == actual.size() &&
+                    std::equal(expected.begin(), expected.end(), actual.begin(), [](const TextRange& a, const TextRange& b) {
+                        return a.start == b.start && a.end == b.end;
+                    });
+        if (!same) {
+            printf("%10zu results differ from the per-check reference (%zu vs %zu)\n", text.size(),
+                   expected.size(), actual.size());
+            continue;
+        }
+        printf("%10zu %14.1f %14.1f %8.1fx %8zu\n", text.size(), MegabytesPerSecond(text.size(), checkTime),
+               MegabytesPerSecond(text.size(), engineTime), checkTime / engineTime, actual.size());
+    }
+}
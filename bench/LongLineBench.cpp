@@ -0,0 +1,118 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include "analysis/BracketIndex.h"
+#include "analysis/DocumentAnalyzer.h"
+#include "analysis/SyntaxStyler.h"
+
+namespace {
+
+// The document as one line, like minified code: MakeCorpus without its
+// comments, newlines turned to spaces
+std::string MakeMinified(size_t bytes) {
+    std::string corpus = MakeCorpus(bytes + bytes / 8);
+    std::string text;
+    text.reserve(corpus.size());
+    for (size_t pos = 0; pos < corpus.size() && text.size() < bytes;) {
+        size_t stop = corpus.find('\n', pos);
+        if (corpus.compare(pos, 2, "//") != 0) text.append(corpus, pos, stop - pos).push_back(' ');
+        pos = stop + 1;
+    }
+    return text;
+}
+
+// A JSON dump on one line
+std::string MakeJsonLine(size_t bytes) {
+    std::string text = "[";
+    for (size_t i = 0; text.size() < bytes; ++i) {
+        text += "{\"id\":" + std::to_string(i) + ",\"name\":\"item" + std::to_string(i % 97) +
+                "\",\"tags\":[\"a\",\"b\"],\"ratio\":0." + std::to_string(i % 1000) + "},";
+    }
+    text.back() = ']';
+    return text;
+}
+
+// One identifier the length of the document: no token boundary anywhere
+std::string MakeOneWord(size_t bytes) {
+    return std::string(bytes, 'x');
+}
+
+// A block comment opened at the start and never closed
+std::string MakeOpenComment(size_t bytes) {
+    std::string text = "/* " + MakeMinified(bytes);
+    text.resize(bytes);
+    return text;
+}
+
+struct LongLineInput {
+    const char* name;
+    std::string (*make)(size_t bytes);
+};
+
+} // namespace
+
+// What the editor does per keystroke in the middle of a single huge line:
+// the worker's incremental analysis, and on the UI thread relexing the line
+// for the bracket index and restyling it as OnStyleNeeded does, which stops
+// lexing at kLongLineBytes
+void RunLongLineBench() {
+    printf("\n== Single-line documents (lines capped at %zu KB), per edit mid-line ==\n", kLongLineBytes >> 10);
+    printf("%-10s %10s %12s %10s %12s %10s\n", "input", "size", "full pass ms", "edit ms", "brackets ms",
+           "style ms");
+
+    const LongLineInput inputs[] = {
+            {"minified", MakeMinified},
+            {"json", MakeJsonLine},
+            {"one word", MakeOneWord},
+            {"comment", MakeOpenComment},
+    };
+    SyntaxStyler styler;
+    styler.SetKeywords(0, "class struct if else for while return switch case break continue void using");
+    for (const LongLineInput& input : inputs) {
+        for (size_t size : {1u << 20, 4u << 20, 20u << 20}) {
+            std::string text = input.make(size);
+            size_t mid = text.size() / 2;
+            std::string edited = text;
+            edited.insert(mid, 1, 'q');
+
+            DocumentAnalyzer analyzer;
+            double full = TimeBest(3, [&] {
+                analyzer.Reset();
+                analyzer.Analyse(text, {0, text.size()}, 0, 1);
+            });
+
+            // Typing a character and taking it out again, so every round
+            // starts from the same text
+            EditRecord insert;
+            insert.position = mid;
+            insert.length = 1;
+            insert.inserted = true;
+            EditRecord remove = insert;
+            remove.inserted = false;
+            double edit = TimeBest(3, [&] {
+                analyzer.ApplyEdit(insert);
+                analyzer.Analyse(edited, {mid, mid + 1}, 0, 1);
+                analyzer.ApplyEdit(remove);
+                analyzer.Analyse(text, {mid, mid}, 0, 1);
+            }) / 2;
+
+            BracketIndex brackets;
+            brackets.Update(text);
+            double bracketTime = TimeBest(3, [&] {
+                brackets.NoteEdit(0, 0);
+                brackets.Update(edited);
+                brackets.NoteEdit(0, 0);
+                brackets.Update(text);
+            }) / 2;
+
+            std::vector<uint8_t> styles;
+            double style = TimeBest(3, [&] {
+                styles.clear();
+                styler.StyleLine(edited, 0, std::min(edited.size(), kLongLineBytes), LexState::Default, styles);
+            });
+
+            printf("%-10s %10zu %12.2f %10.3f %12.3f %10.3f\n", input.name, text.size(), full * 1000, edit * 1000,
+                   bracketTime * 1000, style * 1000);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <thread>
+#include "analysis/DocumentAnalyzer.h"
+
+namespace {
+
+// MakeCorpus with a block comment over a few hundred lines after every few
+// thousand, so piece boundaries land inside comments and the pieces after
+// them have to be lexed again from the real state
+std::string MakeCommentedCorpus(size_t bytes) {
+    std::string clean = MakeCorpus(bytes);
+    std::string text;
+    text.reserve(clean.size() + clean.size() / 64);
+    size_t lines = 0;
+    for (size_t pos = 0; pos < clean.size();) {
+        size_t stop = clean.find('\n', pos) + 1;
+        text.append(clean, pos, stop - pos);
+        pos = stop;
+        lines++;
+        if (lines % 5000 == 0) text += "/* disabled:\n";
+        if (lines % 5000 == 700) text += "*/\n";
+    }
+    return text;
+}
+
+bool SameRanges(const std::vector<TextRange>& a, const std::vector<TextRange>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const TextRange& x, const TextRange& y) {
+        return x.start == y.start && x.end == y.end;
+    });
+}
+
+bool SameResult(const AnalysisResult& a, const AnalysisResult& b) {
+    return SameRanges(a.variables, b.variables) && SameRanges(a.functions, b.functions) &&
+           SameRanges(a.errors, b.errors);
+}
+
+} // namespace
+
+void RunParallelBench() {
+    printf("\n== Full analysis pass (DocumentAnalyzer::Analyse), by thread count ==\n");
+    printf("%10s %8s %10s %10s %9s\n", "size", "threads", "ms", "MB/s", "speedup");
+
+    size_t maxThreads = std::max(4u, std::thread::hardware_concurrency());
+    for (size_t size : {1u << 20, 16u << 20, 64u << 20}) {
+        std::string text = MakeCommentedCorpus(size);
+        int lineCount = static_cast<int>(std::count(text.begin(), text.end(), '\n')) + 1;
+
+        AnalysisResult expected;
+        double baseline = 0;
+        for (size_t threads = 1; threads <= maxThreads; threads *= 2) {
+            ThreadPool pool(threads);
+            DocumentAnalyzer analyzer(pool);
+            AnalysisResult result;
+            double seconds = TimeBest(3, [&] {
+                analyzer.Reset();
+                result = analyzer.Analyse(text, {0, text.size()}, 0, lineCount);
+            });
+            if (threads == 1) {
+                expected = result;
+                baseline = seconds;
+            } else if (!SameResult(expected, result)) {
+                printf("%10zu %8zu results differ from one thread\n", text.size(), threads);
+                continue;
+            }
+            printf("%10zu %8zu %10.1f %10.1f %8.2fx\n", text.size(), threads, seconds * 1000,
+                   MegabytesPerSecond(text.size(), seconds), baseline / seconds);
+        }
+    }
+}
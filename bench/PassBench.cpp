@@ -0,0 +1,243 @@
+#include "Bench.h"
+
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <set>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "analysis/DeclarationScanner.h"
+#include "analysis/DocumentAnalyzer.h"
+#include "analysis/ErrorRules.h"
+#include "analysis/LargeFileMode.h"
+#include "analysis/VariableMatcher.h"
+
+namespace {
+
+// A pass is repeated until its runs add up to this, or kMaxRuns runs; a
+// pass slower than this runs once
+const double kSampleSeconds = 0.5;
+const size_t kMaxRuns = 1000;
+
+// Characters overwritten and put back per corpus for the edit latencies
+const size_t kEdits = 100;
+
+// Passes are run over at most this much of the corpus at a time, in
+// pieces of whole lines, so the tokens of a 500 MB corpus never all exist
+// at once
+const size_t kPieceBytes = 64 << 20;
+
+enum Pass { kLex, kDeclarations, kVariables, kFunctions, kLint, kPassCount };
+const char* const kPassNames[kPassCount] = {"lex", "declarations", "variables", "functions", "lint"};
+
+// Per-run wall times of one pass, sorted
+struct Samples {
+    std::vector<double> seconds;
+
+    double At(double fraction) const {
+        return seconds[std::min(seconds.size() - 1, static_cast<size_t>(fraction * seconds.size()))];
+    }
+};
+
+template <typename Fn>
+double Time(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+template <typename Fn>
+Samples Sample(Fn&& fn) {
+    Samples samples;
+    double total = 0;
+    while (samples.seconds.empty() || (total < kSampleSeconds && samples.seconds.size() < kMaxRuns)) {
+        samples.seconds.push_back(Time(fn));
+        total += samples.seconds.back();
+    }
+    std::sort(samples.seconds.begin(), samples.seconds.end());
+    return samples;
+}
+
+// text in pieces of whole lines of about kPieceBytes
+std::vector<std::string_view> SplitPieces(std::string_view text) {
+    std::vector<std::string_view> pieces;
+    for (size_t pos = 0; pos < text.size();) {
+        size_t nl = pos + kPieceBytes < text.size() ? text.find('\n', pos + kPieceBytes) : std::string::npos;
+        size_t stop = nl == std::string::npos ? text.size() : nl + 1;
+        pieces.push_back(text.substr(pos, stop - pos));
+        pos = stop;
+    }
+    return pieces;
+}
+
+// One row of the table and one entry of the JSON results. `bytes` is what
+// a run goes through, for the throughput; 0 leaves it out.
+nlohmann::json Report(const char* pass, size_t corpus, size_t bytes, size_t items, const Samples& samples) {
+    double median = samples.At(0.5);
+    printf("%10zu %-13s %6zu %10zu %11.3f %11.3f %11.3f", corpus, pass, samples.seconds.size(), items,
+           median * 1000, samples.At(0.99) * 1000, samples.seconds.back() * 1000);
+    if (bytes > 0) printf(" %9.1f", MegabytesPerSecond(bytes, median));
+    printf("\n");
+
+    nlohmann::json entry = {
+            {"pass", pass},
+            {"corpusBytes", corpus},
+            {"runs", samples.seconds.size()},
+            {"items", items},
+            {"latencyMs",
+             {{"min", samples.seconds.front() * 1000},
+              {"median", median * 1000},
+              {"p99", samples.At(0.99) * 1000},
+              {"max", samples.seconds.back() * 1000}}},
+    };
+    if (bytes > 0) entry["megabytesPerSecond"] = MegabytesPerSecond(bytes, median);
+    return entry;
+}
+
+// Where the edits go, with the line each is on: spread at random over the
+// document, none of them on a line break so no edit adds or joins lines
+std::vector<std::pair<size_t, int>> PickEdits(std::string_view text) {
+    std::mt19937_64 rng(56);
+    std::vector<size_t> positions;
+    for (size_t i = 0; i < kEdits; ++i) {
+        size_t pos = rng() % text.size();
+        while (pos > 0 && (text[pos] == '\n' || text[pos] == '\r')) pos--;
+        positions.push_back(pos);
+    }
+    std::sort(positions.begin(), positions.end());
+
+    std::vector<std::pair<size_t, int>> edits;
+    int line = 0;
+    size_t scanned = 0;
+    for (size_t pos : positions) {
+        line += static_cast<int>(std::count(text.begin() + scanned, text.begin() + pos, '\n'));
+        scanned = pos;
+        edits.emplace_back(pos, line);
+    }
+    std::shuffle(edits.begin(), edits.end(), rng);
+    return edits;
+}
+
+} // namespace
+
+// Each analysis pass on its own over the whole corpus: lexing, the
+// declaration scan, variable matching, function names and the error rules.
+// Then DocumentAnalyzer end to end, as the full pass made when a file is
+// opened and as the latency of the incremental pass after a one-character
+// edit, for the sizes LargeFilePolicy leaves analysis on for.
+bool RunPassBench(size_t maxBytes, const std::string& jsonPath) {
+    printf("\n== Analysis passes, up to %zu bytes ==\n", maxBytes);
+    printf("%10s %-13s %6s %10s %11s %11s %11s %9s\n", "size", "pass", "runs", "items", "median ms", "p99 ms",
+           "max ms", "MB/s");
+
+    nlohmann::json results = nlohmann::json::array();
+    LintEngine errorRules(ErrorRules());
+    LargeFilePolicy policy;
+    for (size_t size : {size_t(1) << 10, size_t(16) << 10, size_t(256) << 10, size_t(4) << 20, size_t(64) << 20,
+                        size_t(500) << 20}) {
+        if (size > maxBytes) break;
+        std::string text = MakeCorpus(size);
+        int lineCount = static_cast<int>(std::count(text.begin(), text.end(), '\n')) + 1;
+
+        std::vector<std::string_view> pieces = SplitPieces(text);
+        std::set<std::string> names;
+        for (std::string_view piece : pieces) {
+            for (const Declaration& declaration : ScanDeclarations(piece)) names.insert(declaration.name);
+        }
+        VariableMatcher matcher;
+        matcher.Build(names);
+
+        // One run of every pass per round, each piece lexed once per round
+        // and the other passes reading its tokens
+        Samples samples[kPassCount];
+        size_t items[kPassCount];
+        double total = 0;
+        for (size_t round = 0; round == 0 || (total < kSampleSeconds && round < kMaxRuns); ++round) {
+            double times[kPassCount] = {};
+            std::fill(std::begin(items), std::end(items), 0);
+            for (std::string_view piece : pieces) {
+                std::vector<Token> tokens;
+                std::vector<TextRange> ranges;
+                LintStats stats;
+                times[kLex] += Time([&] { tokens = Tokenize(piece); });
+                items[kLex] += tokens.size();
+                times[kDeclarations] += Time([&] {
+                    items[kDeclarations] += ScanDeclarations(piece, tokens, 0, tokens.size()).size();
+                });
+                times[kVariables] += Time([&] { matcher.FindAll(piece, {0, piece.size()}, ranges); });
+                items[kVariables] += ranges.size();
+                ranges.clear();
+                times[kFunctions] += Time([&] { CollectFunctions(piece, tokens, tokens.size(), ranges); });
+                items[kFunctions] += ranges.size();
+                ranges.clear();
+                times[kLint] += Time([&] { errorRules.Run(piece, tokens, tokens.size(), 0, ranges, stats); });
+                items[kLint] += ranges.size();
+            }
+            for (int pass = 0; pass < kPassCount; ++pass) {
+                samples[pass].seconds.push_back(times[pass]);
+                total += times[pass];
+            }
+        }
+        for (int pass = 0; pass < kPassCount; ++pass) {
+            std::sort(samples[pass].seconds.begin(), samples[pass].seconds.end());
+            results.push_back(Report(kPassNames[pass], text.size(), text.size(), items[pass], samples[pass]));
+        }
+
+        // The editor doesn't analyse documents this large at all
+        if (policy.DisabledIn(policy.TierFor(MeasureDocument(text))) & kCodeAnalysis) {
+            printf("%10zu %-13s skipped: code analysis is off for documents this large\n", text.size(), "analyse");
+            results.push_back({{"pass", "analyse"}, {"corpusBytes", text.size()}, {"skipped", true}});
+            continue;
+        }
+
+        DocumentAnalyzer analyzer;
+        AnalysisResult result;
+        Samples full = Sample([&] {
+            analyzer.Reset();
+            result = analyzer.Analyse(text, {0, text.size()}, 0, lineCount);
+        });
+        results.push_back(Report("analyse", text.size(), text.size(),
+                                 result.variables.size() + result.functions.size() + result.errors.size(), full));
+
+        // Overwriting a character and putting it back, so the text is the
+        // same after every pair
+        Samples edits;
+        for (const auto& [pos, line] : PickEdits(text)) {
+            const char original = text[pos];
+            for (char c : {'q', original}) {
+                EditRecord remove;
+                remove.position = pos;
+                remove.length = 1;
+                remove.line = line;
+                EditRecord insert = remove;
+                insert.inserted = true;
+
+                edits.seconds.push_back(Time([&] {
+                    analyzer.ApplyEdit(remove);
+                    analyzer.ApplyEdit(insert);
+                    text[pos] = c;
+                    analyzer.Analyse(text, {pos, pos + 1}, line, lineCount);
+                }));
+            }
+        }
+        std::sort(edits.seconds.begin(), edits.seconds.end());
+        results.push_back(Report("edit", text.size(), 0, edits.seconds.size(), edits));
+    }
+
+    if (jsonPath.empty()) return true;
+    nlohmann::json document = {
+            {"benchmark", "analysis passes"},
+            {"threads", std::thread::hardware_concurrency()},
+            {"maxBytes", maxBytes},
+            {"results", results},
+    };
+    std::ofstream out(jsonPath);
+    out << document.dump(2) << '\n';
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", jsonPath.c_str());
+        return false;
+    }
+    printf("results written to %s\n", jsonPath.c_str());
+    return true;
+}
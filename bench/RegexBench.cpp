@@ -0,0 +1,70 @@
+#include "Bench.h"
+
+#include <regex>
+#include <vector>
+#include "analysis/RegexSearcher.h"
+
+namespace {
+
+size_t CountStdRegex(const std::string& text, const std::regex& re) {
+    return static_cast<size_t>(std::distance(std::sregex_iterator(text.begin(), text.end(), re),
+                                             std::sregex_iterator()));
+}
+
+} // namespace
+
+// Find-all throughput of RegexSearcher, and of std::regex (backtracking)
+// on a corpus small enough for it, plus a pattern std::regex takes time
+// exponential in the input for
+void RunRegexBench() {
+    printf("\n== Regex find all, MB/s ==\n");
+    printf("%-26s %10s %10s %10s %12s %8s\n", "pattern", "hits", "searcher", "std::regex", "DFA states", "flushes");
+
+    const char* patterns[] = {
+            "count",
+            "\\d+\\.\\d+",
+            "[A-Za-z_]\\w*\\(",
+            "(int|double|float) \\w+",
+            "^\\s*for",
+            "\"[^\"]*\"",
+            "(std::\\w+|return 0;)$",
+    };
+    const std::string text = MakeCorpus(16u << 20);
+    const std::string small = MakeCorpus(256u << 10);
+    for (const char* pattern : patterns) {
+        RegexSearcher searcher;
+        if (!searcher.Compile(pattern)) {
+            printf("%-26s %s\n", pattern, searcher.Error().c_str());
+            continue;
+        }
+        std::vector<TextRange> matches;
+        double seconds = TimeBest(3, [&] {
+            matches.clear();
+            searcher.FindAll(text, {0, text.size()}, matches);
+        });
+
+        // ECMAScript semantics are leftmost-first rather than longest, so
+        // only the times are compared
+        std::regex re(pattern[0] == '^' ? std::string("(?:^|\\n)") + (pattern + 1) : std::string(pattern));
+        double stdSeconds = TimeBest(1, [&] { CountStdRegex(small, re); });
+
+        RegexStats stats = searcher.Stats();
+        printf("%-26s %10zu %10.1f %10.1f %12zu %8zu\n", pattern, matches.size(),
+               MegabytesPerSecond(text.size(), seconds), MegabytesPerSecond(small.size(), stdSeconds),
+               stats.forwardStates + stats.backwardStates, stats.cacheFlushes);
+    }
+
+    // (x+x+)+y against a run of x with no y: every way of splitting the run
+    // is tried by a backtracking engine
+    printf("\n%8s %14s %14s\n", "x run", "searcher ms", "std::regex ms");
+    RegexSearcher searcher;
+    searcher.Compile("(x+x+)+y");
+    std::regex re("(x+x+)+y");
+    for (size_t length : {16, 20, 24}) {
+        std::string run(length, 'x');
+        std::vector<TextRange> matches;
+        double seconds = TimeBest(3, [&] { searcher.FindAll(run, {0, run.size()}, matches); });
+        double stdSeconds = TimeBest(1, [&] { std::regex_search(run, re); });
+        printf("%8zu %14.4f %14.1f\n", length, seconds * 1000, stdSeconds * 1000);
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef GROUP56_WORK_REGEXDECLARATIONS_H
+#define GROUP56_WORK_REGEXDECLARATIONS_H
+
+#include <algorithm>
+#include <cctype>
+#include <regex>
+#include <string>
+#include <vector>
+#include "analysis/DeclarationScanner.h"
+
+// The std::regex recognizer ScanDeclarations replaced, kept as the reference
+// for Group56_bench and Group56_tests. Unlike the token scanner it also
+// picked up words inside string literals and number suffixes (the f of
+// 1.0f) in initializers; those are dropped so both report the same names.
+// It still matches inside comments, which the scanner skips, and takes
+// whitespace alone for an initializer, which the scanner doesn't.
+inline std::vector<Declaration> ScanDeclarationsRegex(const std::string& text, size_t begin, size_t end) {
+    std::vector<Declaration> declarations;
+    std::regex varDeclRegex(
+            R"(\b(bool|int|float|double|string)\b\s+([a-zA-Z_][a-zA-Z0-9_]*)(\s*=\s*[^,;]+)?(\s*,\s*[a-zA-Z_][a-zA-Z0-9_]*(\s*=\s*[^,;]+)?)*\s*;)"
+    );
+    std::smatch match;
+    auto it = text.cbegin() + begin;
+    auto last = text.cbegin() + end;
+
+    while (std::regex_search(it, last, match, varDeclRegex)) {
+        std::string fullDecl = match.str();
+        size_t position = std::distance(text.cbegin(), match[0].first);
+        size_t stop = std::distance(text.cbegin(), match[0].second);
+
+        std::regex nameRegex(R"([a-zA-Z_][a-zA-Z0-9_]*)");
+        std::sregex_iterator nameIt(fullDecl.begin(), fullDecl.end(), nameRegex);
+        std::sregex_iterator endIt;
+        bool skipType = true;
+        for (; nameIt != endIt; ++nameIt) {
+            if (skipType) {
+                skipType = false;
+                continue;
+            }
+            size_t offset = nameIt->position();
+            if (std::count(fullDecl.begin(), fullDecl.begin() + offset, '"') % 2 != 0) continue;
+            if (offset > 0 && (std::isdigit(static_cast<unsigned char>(fullDecl[offset - 1])) ||
+                               fullDecl[offset - 1] == '.')) continue;
+            declarations.push_back({nameIt->str(), position, stop});
+        }
+
+        it = match.suffix().first;
+    }
+
+    return declarations;
+}
+
+inline bool SameDeclarations(const std::vector<Declaration>& a, const std::vector<Declaration>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].name != b[i].name || a[i].position != b[i].position || a[i].end != b[i].end) return false;
+    }
+    return true;
+}
+
+#endif //GROUP56_WORK_REGEXDECLARATIONS_H
@@ -0,0 +1,65 @@
+#include "Bench.h"
+
+#include <vector>
+#include "analysis/BulkReplace.h"
+#include "analysis/SubstringSearcher.h"
+
+namespace {
+
+std::vector<TextRange> FindMatches(const std::string& text, const std::string& query) {
+    SubstringSearcher searcher(query);
+    std::vector<TextRange> matches;
+    for (size_t hit = searcher.Find(text); hit != SubstringSearcher::npos;
+         hit = searcher.Find(text, hit + query.size())) {
+        matches.push_back({hit, hit + query.size()});
+    }
+    return matches;
+}
+
+} // namespace
+
+// Replace all, rebuilding the text once against replacing in place match by
+// match, which moves everything after each match (as Scintilla's buffer
+// does for each ReplaceTarget)
+void RunReplaceBench() {
+    printf("\n== Replace all, ms ==\n");
+    printf("%8s %-10s %10s %12s %12s\n", "MB", "query", "matches", "one pass", "per match");
+
+    const char* queries[] = {"count", "std::cout", "volatile"};
+    for (size_t megabytes : {1, 4, 16}) {
+        const std::string text = MakeCorpus(megabytes << 20);
+        for (const char* query : queries) {
+            std::vector<TextRange> matches = FindMatches(text, query);
+            const std::string replacement = std::string(query) + "_renamed";
+
+            std::string rebuilt;
+            double seconds = TimeBest(3, [&] {
+                std::string middle = ReplaceMatches(text, matches, replacement);
+                rebuilt = matches.empty() ? text
+                                          : text.substr(0, matches.front().start) + middle +
+                                                    text.substr(matches.back().end);
+            });
+
+            // Quadratic, so only run where it finishes in reasonable time
+            double perMatchSeconds = -1;
+            if (megabytes <= 4) {
+                std::string edited;
+                perMatchSeconds = TimeBest(1, [&] {
+                    edited = text;
+                    size_t shift = 0;
+                    for (const TextRange& match : matches) {
+                        edited.replace(match.start + shift, match.Length(), replacement);
+                        shift += replacement.size() - match.Length();
+                    }
+                });
+                if (edited != rebuilt) printf("mismatch for %s\n", query);
+            }
+            printf("%8zu %-10s %10zu %12.2f", megabytes, query, matches.size(), seconds * 1000);
+            if (perMatchSeconds >= 0) {
+                printf(" %12.1f\n", perMatchSeconds * 1000);
+            } else {
+                printf(" %12s\n", "-");
+            }
+        }
+    }
+}
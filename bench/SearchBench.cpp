@@ -0,0 +1,124 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <string_view>
+#include <vector>
+#include "analysis/IncrementalFind.h"
+#include "analysis/SubstringSearcher.h"
+
+namespace {
+
+// Letters that never occur together in MakeCorpus
+std::string MakeNeedle(size_t length) {
+    std::string needle;
+    for (size_t i = 0; i < length; ++i) needle += "zqxjkv"[i % 6];
+    return needle;
+}
+
+// MakeCorpus with the needle written over it every `spacing` bytes (0 for
+// none), after the needle's first letter has already occurred just before,
+// so the first-byte filter also sees near misses
+std::string PlantNeedles(std::string text, const std::string& needle, size_t spacing) {
+    for (size_t pos = spacing; spacing > 0 && pos + needle.size() < text.size(); pos += spacing) {
+        text[pos - 2] = needle[0];
+        text.replace(pos, needle.size(), needle);
+    }
+    return text;
+}
+
+size_t CountStdFind(std::string_view text, std::string_view needle) {
+    size_t count = 0;
+    for (size_t pos = text.find(needle); pos != std::string_view::npos; pos = text.find(needle, pos + needle.size())) {
+        count++;
+    }
+    return count;
+}
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+size_t CountMemmem(std::string_view text, std::string_view needle) {
+    size_t count = 0;
+    const char* end = text.data() + text.size();
+    for (const char* p = text.data();;) {
+        const void* hit = memmem(p, end - p, needle.data(), needle.size());
+        if (!hit) return count;
+        count++;
+        p = static_cast<const char*>(hit) + needle.size();
+    }
+}
+#endif
+
+size_t CountSearcher(std::string_view text, const SubstringSearcher& searcher) {
+    std::vector<size_t> batch;
+    size_t count = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        batch.clear();
+        pos = searcher.FindBatch(text, pos, 4096, batch);
+        count += batch.size();
+    }
+    return count;
+}
+
+} // namespace
+
+// Counting every occurrence in a 64 MB document, as OnFind does, by
+// needle length and by how often the needle occurs
+void RunSearchBench() {
+    printf("\n== Find all (64 MB), MB/s, SubstringSearcher kernel: %s ==\n", SubstringSearcher::KernelName());
+    printf("%7s %10s %10s %12s %10s %10s\n", "needle", "spacing", "hits", "string::find", "memmem", "searcher");
+
+    const std::string corpus = MakeCorpus(64u << 20);
+    for (size_t length : {1, 2, 4, 8, 16, 64}) {
+        std::string needle = MakeNeedle(length);
+        SubstringSearcher searcher(needle);
+        for (size_t spacing : {0, 1 << 20, 4096, 64}) {
+            if (spacing != 0 && spacing <= length + 2) continue;
+            std::string text = PlantNeedles(corpus, needle, spacing);
+
+            size_t expected = 0;
+            size_t found = 0;
+            double stdTime = TimeBest(3, [&] { expected = CountStdFind(text, needle); });
+            double searcherTime = TimeBest(3, [&] { found = CountSearcher(text, searcher); });
+            double memmemTime = 0;
+#if defined(__GLIBC__) || defined(__APPLE__)
+            size_t memmemFound = 0;
+            memmemTime = TimeBest(3, [&] { memmemFound = CountMemmem(text, needle); });
+            if (memmemFound != expected) printf("%7zu %10zu memmem found %zu\n", length, spacing, memmemFound);
+#endif
+            if (found != expected) {
+                printf("%7zu %10zu searcher found %zu, expected %zu\n", length, spacing, found, expected);
+                continue;
+            }
+            printf("%7zu %10zu %10zu %12.0f %10.0f %10.0f\n", length, spacing, expected,
+                   MegabytesPerSecond(text.size(), stdTime), MegabytesPerSecond(text.size(), memmemTime),
+                   MegabytesPerSecond(text.size(), searcherTime));
+        }
+    }
+}
+
+// Typing a query into the find bar one character at a time: how long each
+// keystroke takes to search the viewport and then the whole document,
+// starting over each time against narrowing the previous matches
+void RunIncrementalFindBench() {
+    printf("\n== Find as you type (64 MB, 64 KB viewport), ms per keystroke ==\n");
+    printf("%-10s %10s %12s %12s %12s %12s\n", "query", "hits", "fresh view", "fresh all", "narrow view",
+           "narrow all");
+
+    const std::string text = MakeCorpus(64u << 20);
+    const TextRange viewport{32u << 20, (32u << 20) + (64u << 10)};
+    const std::string word = "compute";
+    IncrementalFind typed;
+    for (size_t length = 1; length <= word.size(); ++length) {
+        std::string query = word.substr(0, length);
+        IncrementalFind fresh;
+        double freshView = TimeBest(1, [&] { fresh.SetQuery(text, query, false, viewport); });
+        double freshAll = freshView + TimeBest(1, [&] { while (fresh.Step(text, 1 << 20)) {} });
+        double narrowView = TimeBest(1, [&] { typed.SetQuery(text, query, false, viewport); });
+        double narrowAll = narrowView + TimeBest(1, [&] { while (typed.Step(text, 1 << 20)) {} });
+        if (typed.Count() != fresh.Count()) {
+            printf("%-10s narrowing found %zu, expected %zu\n", query.c_str(), typed.Count(), fresh.Count());
+            continue;
+        }
+        printf("%-10s %10zu %12.2f %12.2f %12.2f %12.2f\n", query.c_str(), fresh.Count(), freshView * 1000,
+               freshAll * 1000, narrowView * 1000, narrowAll * 1000);
+    }
+}
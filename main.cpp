@@ -9,19 +9,30 @@
 #include <thread>
 #include <fstream>
 #include <curl/curl.h>
-#include <regex>
-#include <set>
 #include <wx/url.h>
 #include <wx/sstream.h>
 #include <wx/wfstream.h>
 #include <filesystem>
+#include <functional>
 #include <nlohmann/json.hpp> // Include JSON library (needs nlohmann_json)
+#include "analysis/AnalysisScheduler.h"
+#include "analysis/AnalysisWorker.h"
+#include "analysis/BracketIndex.h"
+#include "analysis/BulkReplace.h"
+#include "analysis/DirtyRange.h"
+#include "analysis/IncrementalFind.h"
+#include "analysis/IndicatorLayer.h"
+#include "analysis/LargeFileMode.h"
+#include "analysis/StageStats.h"
+#include "analysis/SyntaxStyler.h"
+#include "analysis/Utf8.h"
 
 
 class MyEditor : public wxStyledTextCtrl {
 public:
     MyEditor(wxWindow* parent) : wxStyledTextCtrl(parent, wxID_ANY) {
-        SetLexer(wxSTC_LEX_CPP);
+        // Colouring comes from our own lexer, see OnStyleNeeded
+        SetLexer(wxSTC_LEX_CONTAINER);
 
 /// Default text style: Menlo, regular
         wxFont editorFont(14, wxFONTFAMILY_MODERN, wxFONTSTYLE_NORMAL, wxFONTWEIGHT_NORMAL, false, "Menlo");
@@ -60,8 +71,8 @@ public:
         StyleSetBold(wxSTC_C_WORD2, true);
         StyleSetBold(wxSTC_C_GLOBALCLASS, true);
 
-        SetKeyWords(0, "class struct if else for while return switch case break continue void using");
-        SetKeyWords(1, "public private protected virtual override const int bool float double string include namespace");
+        m_styler.SetKeywords(0, "class struct if else for while return switch case break continue void using");
+        m_styler.SetKeywords(1, "public private protected virtual override const int bool float double string include namespace");
 
 
         // Indicator 0 for variables
@@ -74,16 +85,39 @@ public:
         IndicatorSetForeground(1, wxColour(173, 216, 230)); // light blue highlight
         IndicatorSetAlpha(1, 80); // semi-transparent
 
+        // Indicator 3 for find matches
+        IndicatorSetStyle(3, wxSTC_INDIC_ROUNDBOX);
+        IndicatorSetForeground(3, wxColour(255, 255, 0)); // Yellow highlight
+        IndicatorSetAlpha(3, 80);
+
         // Indicator 4 for errors (red squiggly underline)
         IndicatorSetStyle(4, wxSTC_INDIC_SQUIGGLE);
         IndicatorSetForeground(4, wxColour(255, 0, 0));  // Red underline
         IndicatorSetAlpha(4, 255);                       // Fully opaque
 
-        // Real-time syntax highlighting + variable and error highlighting
-        Bind(wxEVT_STC_CHANGE, [this](wxStyledTextEvent&) {
-            Colourise(0, GetTextLength());
-            HighlightVariables(); // Highlight variables dynamically
-            HighlightErrors();    // Underline basic errors dynamically
+        // Indicator 5 for brackets without a partner
+        IndicatorSetStyle(5, wxSTC_INDIC_BOX);
+        IndicatorSetForeground(5, wxColour(255, 0, 0));
+
+        // Real-time syntax highlighting + variable and error highlighting.
+        // Edits are recorded as they happen and only the statements they
+        // touched are re-lexed, re-scanned and re-indicated.
+        Bind(wxEVT_STC_MODIFIED, [this](wxStyledTextEvent& event) {
+            OnTextModified(event);
+            event.Skip();
+        });
+        Bind(wxEVT_STC_STYLENEEDED, [this](wxStyledTextEvent& event) {
+            OnStyleNeeded(event.GetPosition());
+        });
+
+        // Bursts of edits (paste, replace all, macros) are coalesced and
+        // analysed once things go quiet, or when the scheduler's staleness
+        // bound is hit
+        m_analysisTimer.SetOwner(this);
+        Bind(wxEVT_TIMER, [this](wxTimerEvent&) { RunScheduledAnalysis(); }, m_analysisTimer.GetId());
+        Bind(wxEVT_IDLE, [this](wxIdleEvent& event) {
+            RunScheduledAnalysis();
+            event.Skip();
         });
 
         // Enable automatic caret and line updates
@@ -92,6 +126,9 @@ public:
         SetViewEOL(false);
         SetViewWhiteSpace(wxSTC_WS_INVISIBLE);
         SetWrapMode(wxSTC_WRAP_NONE);
+        // Keep the layout of the lines on screen, so a long line isn't laid
+        // out again on every repaint
+        SetLayoutCache(wxSTC_CACHE_PAGE);
         // Highlight current line
 
         // --- Auto indentation and brace completion ---
@@ -101,23 +138,15 @@ public:
         SetBackSpaceUnIndents(true);  // backspace will unindent
         SetIndentationGuides(wxSTC_IV_LOOKBOTH);
 
-        // Highlight matching braces
-        Bind(wxEVT_STC_UPDATEUI, [this](wxStyledTextEvent&) {
-            int caretPos = GetCurrentPos();
-            char ch = GetCharAt(caretPos - 1);
-
-            int braceAtCaret = -1;
-            if (ch == '(' || ch == ')' || ch == '{' || ch == '}' ||
-                ch == '[' || ch == ']') {
-                braceAtCaret = caretPos - 1;
-            }
-
-            int braceOpposite = BraceMatch(braceAtCaret);
-            if (braceAtCaret != -1 && braceOpposite != -1) {
-                BraceHighlight(braceAtCaret, braceOpposite);
-            } else {
-                BraceBadLight(braceAtCaret);
-            }
+        // Brace matching, the whole-line selection fixup, the analysis
+        // viewport and the viewport handler all hang off one UPDATEUI
+        // handler; see OnUpdateUI
+        m_uiStats.stages = {StageStats{"Bracket index"}, StageStats{"Brace highlight"},
+                            StageStats{"Line selection"}, StageStats{"Analysis viewport"},
+                            StageStats{"Viewport handler"}};
+        Bind(wxEVT_STC_UPDATEUI, [this](wxStyledTextEvent& event) {
+            OnUpdateUI(event.GetUpdated());
+            event.Skip();
         });
 
         // --- Smart braces, auto completion and indentation ---
@@ -224,24 +253,6 @@ public:
 
             event.Skip();
         });
-
-        // --- Ensure caret stays at end of line when selecting a whole line ---
-        Bind(wxEVT_STC_UPDATEUI, [this](wxStyledTextEvent&) {
-            long start, end;
-            GetSelection(&start, &end);
-
-            // If selection spans exactly one line from start to end-of-line
-            if (LineFromPosition(start) == LineFromPosition(end) && start != end) {
-                int line = LineFromPosition(start);
-                int lineStart = PositionFromLine(line);
-                int lineEnd = GetLineEndPosition(line);
-
-                if (start == lineStart && end == lineEnd) {
-                    // Move caret to end of the line
-                    GotoPos(lineEnd);
-                }
-            }
-        });
     }
 
     bool isRecordingMacro = false;
@@ -263,152 +274,649 @@ public:
             }
         }
     }
+    const SchedulerStats& GetAnalysisStats() const { return m_scheduler.Stats(); }
+
+    void SetAnalysisDelays(int quietMs, int maxStaleMs) {
+        m_scheduler.SetQuietPeriod(std::chrono::milliseconds(quietMs));
+        m_scheduler.SetMaxStaleness(std::chrono::milliseconds(maxStaleMs));
+    }
+
     void SetFilename(const wxString& filename) { m_filename = filename; }
     wxString GetFilename() const { return m_filename; }
 
+    // --- Large-file mode ---
+    // A document that reaches a tier of the policy (see LargeFileMode.h) is
+    // opened without that tier's features, and loses more of them if edits
+    // take it into a further tier. Any of them can be turned back on.
+    void SetLargeFilePolicy(const LargeFilePolicy* policy) { m_largeFilePolicy = policy; }
+    void SetFeaturesChangedHandler(std::function<void()> handler) { m_onFeaturesChanged = std::move(handler); }
 
-    std::set<std::string> FetchVariables() {
-        std::set<std::string> variables;
-        std::string text = GetText().ToStdString();
+    // Called from OnUpdateUI when the editor has scrolled vertically
+    void SetViewportChangedHandler(std::function<void()> handler) { m_onViewportChanged = std::move(handler); }
 
-        // Regex to match variable declarations with optional initialization and comma separation
-        std::regex varDeclRegex(
-                R"(\b(bool|int|float|double|string)\b\s+([a-zA-Z_][a-zA-Z0-9_]*)(\s*=\s*[^,;]+)?(\s*,\s*[a-zA-Z_][a-zA-Z0-9_]*(\s*=\s*[^,;]+)?)*\s*;)"
-        );
+    bool IsFeatureEnabled(LargeFileFeature feature) const { return !(m_disabledFeatures & feature); }
 
-        std::smatch match;
-        auto it = text.cbegin();
+    void SetFeatureEnabled(LargeFileFeature feature, bool enabled) {
+        if (IsFeatureEnabled(feature) == enabled) return;
+        ApplyFeature(feature, enabled);
+        if (m_onFeaturesChanged) m_onFeaturesChanged();
+    }
 
-        while (std::regex_search(it, text.cend(), match, varDeclRegex)) {
-            std::string fullDecl = match.str();
+    // Word wrap as the user asked for it; it only shows while the feature is enabled
+    void SetWordWrap(bool wrap) {
+        m_wrapWanted = wrap;
+        UpdateWrapMode();
+    }
 
-            // Extract each variable name from the declaration
-            std::regex nameRegex(R"([a-zA-Z_][a-zA-Z0-9_]*)");
-            std::sregex_iterator nameIt(fullDecl.begin(), fullDecl.end(), nameRegex);
-            std::sregex_iterator endIt;
+    // Whether a document with lines past kLongLineBytes shows them cut into
+    // screen-wide segments when it isn't word wrapped
+    void SetSegmentLongLines(bool segment) {
+        m_segmentLongLines = segment;
+        UpdateWrapMode();
+    }
 
-            bool skipType = true; // Skip the first match (type)
-            for (; nameIt != endIt; ++nameIt) {
-                std::string varName = nameIt->str();
+    // e.g. "Large file (Huge): code analysis, brace matching off", or
+    // nothing for an ordinary document
+    wxString LargeFileStatus() const {
+        wxString status;
+        if (m_largeFileTier >= 0) {
+            wxString off;
+            for (LargeFileFeature feature : kLargeFileFeatures) {
+                if (IsFeatureEnabled(feature)) continue;
+                if (!off.empty()) off += ", ";
+                off += FeatureLabel(feature);
+            }
+            wxString tier = m_largeFilePolicy->Tiers()[m_largeFileTier].name;
+            status = wxString::Format("Large file (%s): %s", tier, off.empty() ? wxString("all features on") : off + " off");
+        }
+        if (HasLongLines()) {
+            if (!status.empty()) status += "; ";
+            status += wxString::Format("long lines only coloured and analysed in their first %d KB",
+                                       static_cast<int>(kLongLineBytes >> 10));
+        }
+        return status;
+    }
 
-                if (skipType) {
-                    skipType = false; // Skip the type name
-                    continue;
-                }
 
-                variables.insert(varName); // Add variable name
-            }
+    // Goes up by one with every insert and delete
+    uint64_t TextVersion() const { return m_textVersion; }
 
-            it = match.suffix().first;
+    // The lines on screen, whole
+    TextRange ScreenRange() {
+        int first = DocLineFromVisible(GetFirstVisibleLine());
+        int last = first + LinesOnScreen() + 1;
+        size_t end = last < GetLineCount() ? PositionFromLine(last) : GetTextLength();
+        return {static_cast<size_t>(PositionFromLine(first)), end};
+    }
+
+    // The document's bytes where Scintilla keeps them, without copying or
+    // transcoding; offsets are Scintilla positions. Only valid until the
+    // next modification.
+    std::string_view BufferView() const {
+        return std::string_view(GetCharacterPointer(), GetTextLength());
+    }
+
+    // Puts `bytes` in place of the range as one undo step. That is one
+    // deletion and one insertion, so one burst to the analysis scheduler.
+    void ReplaceRange(const TextRange& range, std::string_view bytes) {
+        BeginUndoAction();
+        SetTargetRange(static_cast<int>(range.start), static_cast<int>(range.end));
+        ReplaceTargetRaw(bytes.data(), static_cast<int>(bytes.size()));
+        EndUndoAction();
+    }
+
+    // Loads a file's bytes into the buffer unchanged when they are valid
+    // UTF-8, so buffer positions are offsets into the file; anything else is
+    // read as Latin-1. Returns false if the file can't be read.
+    bool LoadDocument(const wxString& path, bool& readAsLatin1) {
+        std::ifstream in(path.fn_str(), std::ios::binary | std::ios::ate);
+        if (!in) return false;
+        std::string bytes(static_cast<size_t>(in.tellg()), '\0');
+        in.seekg(0);
+        if (!in.read(&bytes[0], bytes.size())) return false;
+
+        readAsLatin1 = !IsValidUtf8(bytes);
+        if (readAsLatin1) bytes = Latin1ToUtf8(bytes);
+
+        // Before the text goes in, so nothing that is about to be turned
+        // off gets to run over it first
+        DocumentShape shape = MeasureDocument(bytes);
+        m_longestLine = shape.longestLine;
+        if (m_largeFilePolicy) EnterLargeFileTier(m_largeFilePolicy->TierFor(shape));
+        UpdateWrapMode();
+
+        ClearAll();
+        AddTextRaw(bytes.data(), static_cast<int>(bytes.size()));
+        EmptyUndoBuffer();
+        SetSavePoint();
+        GotoPos(0);
+        return true;
+    }
+
+    void HighlightVariables(const AnalysisResult& result) {
+        // Highlight variables (Indicator 0) and function names (Indicator 1)
+        ApplyIndicator(0, m_variableMarks, result.variableRange, result.variables);
+        ApplyIndicator(1, m_functionMarks, result.functionRange, result.functions);
+    }
+
+    IndicatorStats GetIndicatorStats() const {
+        IndicatorStats total;
+        for (const IndicatorLayer* layer : {&m_variableMarks, &m_functionMarks, &m_errorMarks, &m_bracketMarks}) {
+            total.rangesRequested += layer->Stats().rangesRequested;
+            total.fillCalls += layer->Stats().fillCalls;
+            total.clearCalls += layer->Stats().clearCalls;
         }
+        return total;
+    }
 
-        return variables;
+    const StylingStats& GetStylingStats() const { return m_stylingStats; }
+    const LintStats& GetLintStats() const { return m_lintStats; }
+    const HighlightCacheStats& GetHighlightCacheStats() const { return m_highlightCacheStats; }
+    const UiUpdateStats& GetUiStats() const { return m_uiStats; }
+
+
+private:
+    wxString m_filename;
+
+    // Edits not yet covered by an applied analysis result. The range is only
+    // cleared once a result for the current generation lands, so a dropped
+    // stale result is always redone by the next job.
+    DirtyRange m_dirty;
+    std::vector<EditRecord> m_pendingEdits;
+    uint64_t m_generation = 0;
+    uint64_t m_textVersion = 0;
+    AnalysisScheduler m_scheduler;
+    wxTimer m_analysisTimer;
+    bool m_resync = false;  // a result was dropped; its repaint must be redone
+    LintStats m_lintStats;  // summed over every result, applied or not
+    HighlightCacheStats m_highlightCacheStats;  // as of the latest result
+
+    // Documents larger than this get their document-wide highlighting done
+    // viewport first, in slices, while the worker is otherwise idle
+    static constexpr int kViewportPriorityBytes = 1 << 20;
+    static constexpr size_t kHighlightSliceBytes = 256 << 10;
+
+    // Syntax colouring. Each line's Scintilla line state holds the lexer
+    // state at its end. m_styledEnd is how far styling has ever reached,
+    // moved along by edits, and m_styleDirty the edits not restyled yet.
+    SyntaxStyler m_styler;
+    DirtyRange m_styleDirty;
+    size_t m_styledEnd = 0;
+    std::vector<uint8_t> m_styleBuffer;
+    StylingStats m_stylingStats;
+
+    // Scintilla style for each SyntaxStyle
+    static constexpr uint8_t kStyleFor[] = {
+            wxSTC_C_DEFAULT, wxSTC_C_WORD, wxSTC_C_WORD2, wxSTC_C_IDENTIFIER, wxSTC_C_NUMBER,
+            wxSTC_C_STRING, wxSTC_C_STRINGEOL, wxSTC_C_CHARACTER, wxSTC_C_COMMENT, wxSTC_C_COMMENTLINE,
+            wxSTC_C_COMMENTDOC, wxSTC_C_PREPROCESSOR, wxSTC_C_OPERATOR};
+    static_assert(sizeof(kStyleFor) == static_cast<size_t>(SyntaxStyle::Count), "one style per SyntaxStyle");
+
+    // What indicators 0, 1 and 4 currently show, so results only repaint changes
+    IndicatorLayer m_variableMarks;
+    IndicatorLayer m_functionMarks;
+    IndicatorLayer m_errorMarks;
+    IndicatorLayer m_bracketMarks;
+
+    // Code brackets of the document, for brace matching and indicator 5
+    BracketIndex m_brackets;
+    uint64_t m_bracketVersion = 0;  // of the index when indicator 5 was last painted
+
+    // The UPDATEUI stages, what they last saw and what they cost
+    enum UiStage { kBracketIndexStage, kBraceHighlightStage, kLineSelectionStage, kViewportStage,
+                   kViewportHandlerStage };
+    int m_lastCaret = -1;
+    long m_lastSelectionStart = -1;
+    long m_lastSelectionEnd = -1;
+    UiUpdateStats m_uiStats;
+    std::function<void()> m_onViewportChanged;
+
+    // Large-file mode: the tier the document is in (-1 for none) and the
+    // LargeFileFeature bits currently off, whether by the tier or by hand
+    const LargeFilePolicy* m_largeFilePolicy = nullptr;
+    int m_largeFileTier = -1;
+    uint32_t m_disabledFeatures = 0;
+    size_t m_longestLine = 0;  // at least as long as any line, see NoteInsertedLines
+    bool m_wrapWanted = false;
+    bool m_segmentLongLines = false;
+    bool m_analysisReset = false;  // edits went unrecorded while analysis was off
+    std::function<void()> m_onFeaturesChanged;
+
+    // Declared last so the thread is joined before the state above goes away
+    AnalysisWorker m_worker{[this](AnalysisResult result) {
+        CallAfter([this, result = std::move(result)]() { ApplyAnalysis(result); });
+    }};
+
+    // Moves the document up to `tier`, turning off what that tier and the
+    // ones before it turn off. Documents never move down a tier on their own.
+    void EnterLargeFileTier(int tier) {
+        if (tier <= m_largeFileTier) return;
+        uint32_t newlyDisabled = m_largeFilePolicy->DisabledIn(tier) & ~m_largeFilePolicy->DisabledIn(m_largeFileTier);
+        m_largeFileTier = tier;
+        for (LargeFileFeature feature : kLargeFileFeatures) {
+            if ((newlyDisabled & feature) && IsFeatureEnabled(feature)) ApplyFeature(feature, false);
+        }
+        if (m_onFeaturesChanged) m_onFeaturesChanged();
+    }
+
+    void ApplyFeature(LargeFileFeature feature, bool enabled) {
+        if (enabled) {
+            m_disabledFeatures &= ~feature;
+        } else {
+            m_disabledFeatures |= feature;
+        }
+        TextRange whole{0, static_cast<size_t>(GetTextLength())};
+
+        switch (feature) {
+        case kSyntaxColouring:
+            // The null lexer never asks for styling. Turned back on, styling
+            // starts over from the top as far as the screen needs it.
+            SetLexer(enabled ? wxSTC_LEX_CONTAINER : wxSTC_LEX_NULL);
+            m_styledEnd = 0;
+            m_styleDirty.Clear();
+            ClearDocumentStyle();
+            break;
+        case kCodeAnalysis:
+            if (enabled) {
+                // The worker's state missed every edit since it was turned off
+                m_analysisReset = true;
+                m_dirty.Clear();
+                m_dirty.Insert(0, whole.end);
+                SubmitAnalysis();
+            } else {
+                m_generation++;
+                m_worker.Cancel(m_generation);
+                m_analysisTimer.Stop();
+                m_pendingEdits.clear();
+                m_dirty.Clear();
+                ApplyIndicator(0, m_variableMarks, whole, {});
+                ApplyIndicator(1, m_functionMarks, whole, {});
+                ApplyIndicator(4, m_errorMarks, whole, {});
+            }
+            break;
+        case kBraceMatching:
+            m_brackets.Reset();
+            if (enabled) {
+                UpdateBrackets();
+                HighlightBraces(GetCurrentPos());
+            } else {
+                m_bracketVersion = m_brackets.Version();
+                ApplyIndicator(5, m_bracketMarks, whole, {});
+                BraceHighlight(wxSTC_INVALID_POSITION, wxSTC_INVALID_POSITION);
+            }
+            break;
+        case kWordWrap:
+            UpdateWrapMode();
+            break;
+        }
+    }
+
+    // Lines lexing stops part way through; see kLongLineBytes
+    bool HasLongLines() const { return m_longestLine > kLongLineBytes; }
+
+    // Word wrap where it is wanted and enabled. Otherwise long lines are cut
+    // into segments at any character if asked for: minified code has few
+    // spaces to wrap at, and the marks show where a segment carries on.
+    void UpdateWrapMode() {
+        bool segment = m_segmentLongLines && HasLongLines();
+        if (m_wrapWanted && IsFeatureEnabled(kWordWrap)) {
+            SetWrapMode(wxSTC_WRAP_WORD);
+        } else {
+            SetWrapMode(segment ? wxSTC_WRAP_CHAR : wxSTC_WRAP_NONE);
+        }
+        SetWrapVisualFlags(segment ? wxSTC_WRAPVISUALFLAG_END : wxSTC_WRAPVISUALFLAG_NONE);
     }
 
-    void HighlightVariables() {
-        // Fetch variable names
-        auto variables = FetchVariables();
-        std::string text = GetText().ToStdString();
+    // Grows m_longestLine to cover the lines an insert touched. The lines it
+    // starts and ends on are measured by their positions; any lines between
+    // are wholly inserted text, scanned only if there are some.
+    void NoteInsertedLines(const EditRecord& edit) {
+        auto lineLength = [this](int line) {
+            return static_cast<size_t>(GetLineEndPosition(line) - PositionFromLine(line));
+        };
+        size_t longest = std::max(lineLength(edit.line), lineLength(edit.line + edit.linesAdded));
+        if (edit.linesAdded > 1) {
+            longest = std::max(longest, MeasureDocument(BufferView().substr(edit.position, edit.length)).longestLine);
+        }
+        m_longestLine = std::max(m_longestLine, longest);
+    }
 
-        // Clear old highlights
-        SetIndicatorCurrent(0);
-        IndicatorClearRange(0, GetTextLength());
-        SetIndicatorCurrent(1);
-        IndicatorClearRange(0, GetTextLength());
+    void OnTextModified(wxStyledTextEvent& event) {
+        int type = event.GetModificationType();
+        if (!(type & (wxSTC_MOD_INSERTTEXT | wxSTC_MOD_DELETETEXT))) return;
+
+        EditRecord edit;
+        edit.position = event.GetPosition();
+        edit.length = event.GetLength();
+        edit.inserted = (type & wxSTC_MOD_INSERTTEXT) != 0;
+        edit.line = LineFromPosition(edit.position);
+        edit.linesAdded = event.GetLinesAdded();
+
+        m_textVersion++;
+        m_generation++;
+        m_worker.Cancel(m_generation);  // whatever it is on is outdated now
+        bool analysing = IsFeatureEnabled(kCodeAnalysis);
+        if (analysing) m_pendingEdits.push_back(edit);
+        if (IsFeatureEnabled(kBraceMatching)) m_brackets.NoteEdit(edit.line, edit.linesAdded);
+        for (IndicatorLayer* layer : {&m_variableMarks, &m_functionMarks, &m_errorMarks, &m_bracketMarks}) {
+            if (edit.inserted) {
+                layer->NoteInsert(edit.position, edit.length);
+            } else {
+                layer->NoteDelete(edit.position, edit.length);
+            }
+        }
+        if (edit.inserted) {
+            m_dirty.Insert(edit.position, edit.length);
+            m_styleDirty.Insert(edit.position, edit.length);
+            if (edit.position < m_styledEnd) m_styledEnd += edit.length;
+        } else {
+            m_dirty.Delete(edit.position, edit.length);
+            m_styleDirty.Delete(edit.position, edit.length);
+            if (edit.position < m_styledEnd) m_styledEnd -= std::min(edit.length, m_styledEnd - edit.position);
+        }
 
-        // Highlight variables (Indicator 0)
-        SetIndicatorCurrent(0);
-        for (const auto& var : variables) {
-            size_t pos = text.find(var);
-            while (pos != std::string::npos) {
-                IndicatorFillRange(pos, var.size());
-                pos = text.find(var, pos + var.size());
+        // Growing into a further tier, or getting a long line. Lexers and
+        // wrapping can't be switched from inside a modification
+        // notification, so that waits.
+        if (edit.inserted) {
+            bool hadLongLines = HasLongLines();
+            NoteInsertedLines(edit);
+            if (HasLongLines() && !hadLongLines) {
+                CallAfter([this] {
+                    UpdateWrapMode();
+                    if (m_onFeaturesChanged) m_onFeaturesChanged();
+                });
+            }
+            if (m_largeFilePolicy) {
+                DocumentShape shape{static_cast<size_t>(GetTextLength()), static_cast<size_t>(GetLineCount()),
+                                    m_longestLine};
+                int tier = m_largeFilePolicy->TierFor(shape);
+                if (tier > m_largeFileTier) CallAfter([this, tier] { EnterLargeFileTier(tier); });
             }
         }
 
-        // Highlight function names (Indicator 1)
-        std::regex funcRegex(R"(\b([a-zA-Z_][a-zA-Z0-9_]*)\s*\()");
-        std::smatch match;
-        auto it = text.cbegin();
+        if (!analysing) return;
+        // The document is snapshotted later, once the burst is over
+        auto now = AnalysisScheduler::Clock::now();
+        m_scheduler.NoteEdit(now);
+        if (!m_analysisTimer.IsRunning()) {
+            m_analysisTimer.StartOnce(static_cast<int>(m_scheduler.TimeUntilDue(now).count()) + 1);
+        }
+    }
+
+    void RunScheduledAnalysis() {
+        if (!m_scheduler.IsPending()) return;
+
+        auto now = AnalysisScheduler::Clock::now();
+        if (m_scheduler.IsDue(now)) {
+            m_analysisTimer.Stop();
+            SubmitAnalysis();
+        } else if (!m_analysisTimer.IsRunning()) {
+            m_analysisTimer.StartOnce(static_cast<int>(m_scheduler.TimeUntilDue(now).count()) + 1);
+        }
+    }
+
+    void SubmitAnalysis() {
+        m_scheduler.NoteAnalysisRun();
+        if (!m_dirty.IsSet()) return;
+
+        AnalysisJob job;
+        job.generation = m_generation;
+        job.snapshot = std::make_shared<const std::string>(BufferView());  // the worker can't share the live buffer
+        job.edits = std::move(m_pendingEdits);
+        job.dirty = m_dirty.Range();
+        job.firstLine = LineFromPosition(job.dirty.start);
+        job.lineCount = GetLineCount();
+        job.resync = m_resync;
+        job.reset = m_analysisReset;
+        m_pendingEdits.clear();
+        m_resync = false;
+        m_analysisReset = false;
+
+        UpdateAnalysisViewport();
+        m_worker.Submit(std::move(job));
+    }
+
+    // The visible lines plus a screenful either side, or nothing for
+    // documents small enough to highlight in one go
+    void UpdateAnalysisViewport() {
+        if (GetTextLength() <= kViewportPriorityBytes) {
+            m_worker.SetViewport(TextRange(), 0);
+            return;
+        }
+        int screen = LinesOnScreen();
+        int first = DocLineFromVisible(GetFirstVisibleLine());
+        int from = std::max(first - screen, 0);
+        int to = first + 2 * screen + 1;
+        size_t end = to < GetLineCount() ? PositionFromLine(to) : GetTextLength();
+        m_worker.SetViewport({static_cast<size_t>(PositionFromLine(from)), end}, kHighlightSliceBytes);
+    }
+
+    void ApplyAnalysis(const AnalysisResult& result) {
+        // Turned off since; its indicators are gone and stay gone
+        if (!IsFeatureEnabled(kCodeAnalysis)) return;
+
+        // Given up part way; the worker kept what it owes the screen, and
+        // m_dirty still covers the edits
+        if (result.cancelled) {
+            m_scheduler.NoteCancelled();
+            m_lintStats.Add(result.lint);
+            return;
+        }
+
+        // The text changed since the snapshot was taken; a newer job is on its way
+        bool current = result.generation == m_generation;
+        m_scheduler.NoteResult(current);
+        m_lintStats.Add(result.lint);
+        if (result.cache.lookups) m_highlightCacheStats = result.cache;
+        if (!current) {
+            m_resync = true;
+            return;
+        }
+        m_dirty.Clear();
+
+        HighlightVariables(result); // Highlight variables dynamically
+        HighlightErrors(result);    // Underline basic errors dynamically
+    }
+
+    // Styles from the first unstyled line up to endPos, resuming from the
+    // lexer state stored on the line before. Once past the edited lines, a
+    // line that ends in the same state as it did last time means the text
+    // after it keeps its old styling, so that part is only marked styled.
+    void OnStyleNeeded(size_t endPos) {
+        std::string_view text = BufferView();
+        endPos = std::min(endPos, text.size());
+        int lineCount = GetLineCount();
+        int line = LineFromPosition(GetEndStyled());
+        size_t pos = PositionFromLine(line);
+        int editedLine = m_styleDirty.IsSet() ? LineFromPosition(m_styleDirty.Range().end) : -1;
+        m_stylingStats.passes++;
+
+        while (pos < endPos) {
+            LexState state = line > 0 ? static_cast<LexState>(GetLineState(line - 1)) : LexState::Default;
+            bool converged = false;
+            StartStyling(pos);
+            for (; pos < endPos && line < lineCount; ++line) {
+                size_t stop = line + 1 < lineCount ? PositionFromLine(line + 1) : text.size();
+                int previous = GetLineState(line);
+                // Lexing stops kLongLineBytes into a line; the rest of a
+                // long line is plain, and styled without the buffer
+                size_t lexed = std::min(stop, pos + kLongLineBytes);
+                state = m_styler.StyleLine(text, pos, lexed, state, m_styleBuffer);
+                if (lexed < stop) {
+                    FlushStyles();
+                    SetStyling(static_cast<int>(stop - lexed), wxSTC_C_DEFAULT);
+                }
+                SetLineState(line, static_cast<int>(state));
+                m_stylingStats.linesStyled++;
+                pos = stop;
+                if (line > editedLine && stop <= m_styledEnd && previous == static_cast<int>(state)) {
+                    converged = true;
+                    ++line;
+                    break;
+                }
+            }
 
-        while (std::regex_search(it, text.cend(), match, funcRegex)) {
-            if (match.size() > 1) {
-                std::string funcName = match[1];
-                size_t pos = match.position(1) + std::distance(text.cbegin(), it);
+            FlushStyles();
+            if (!converged) {
+                // Lines past here were styled from a state chain that no
+                // longer holds, so none of them can be skipped later
+                m_styledEnd = pos;
+                break;
+            }
 
-                SetIndicatorCurrent(1);
-                IndicatorFillRange(pos, funcName.size());
+            // Skip to the line holding the old styled end and carry on from
+            // there if the request reaches further
+            int resume = LineFromPosition(m_styledEnd);
+            if (resume > line) {
+                m_stylingStats.linesSkipped += resume - line;
+                line = resume;
+                pos = PositionFromLine(line);
+                StartStyling(pos);
             }
-            it = match.suffix().first;
         }
+
+        m_styledEnd = std::max(m_styledEnd, static_cast<size_t>(GetEndStyled()));
+        // Styling ends on line ends, so this means the last edited line is done
+        size_t styled = GetEndStyled();
+        if (m_styleDirty.IsSet() && (styled > m_styleDirty.Range().end || styled == text.size())) m_styleDirty.Clear();
     }
 
+    // Hands the buffered styles to Scintilla, from where styling has got to
+    void FlushStyles() {
+        for (uint8_t& style : m_styleBuffer) style = kStyleFor[style];
+        SetStyleBytes(m_styleBuffer.size(), reinterpret_cast<char*>(m_styleBuffer.data()));
+        m_styleBuffer.clear();
+    }
 
-private:
-    wxString m_filename;
+    void HighlightErrors(const AnalysisResult& result) {
+        ApplyIndicator(4, m_errorMarks, result.errorRange, result.errors);
+    }
 
-    void HighlightErrors() {
-        // Clear previous error highlights
-        SetIndicatorCurrent(4);
-        IndicatorClearRange(0, GetTextLength());
-
-        std::string text = GetText().ToStdString();
-
-        // 1. Missing semicolon check (simple heuristic)
-        std::regex missingSemicolon(R"(\b(return|int|float|double|bool|string)\b[^;{}\n]*\n)");
-        for (auto it = std::sregex_iterator(text.begin(), text.end(), missingSemicolon);
-             it != std::sregex_iterator(); ++it) {
-            size_t pos = it->position();
-            size_t len = it->length();
-            SetIndicatorCurrent(4);
-            IndicatorFillRange(pos, len);
-        }
-
-        // 2. Mismatched quote detection
-        size_t quoteCount = 0;
-        for (size_t i = 0; i < text.size(); i++) {
-            if (text[i] == '"' && (i == 0 || text[i-1] != '\\')) quoteCount++;
-        }
-        if (quoteCount % 2 != 0) {
-            // Highlight last unmatched quote
-            size_t pos = text.find_last_of('"');
-            SetIndicatorCurrent(4);
-            IndicatorFillRange(pos, 1);
-        }
-
-        // 3. Detect 'cout >>' misuse (should be <<)
-        std::regex coutMisuse(R"(\bcout\s*>>)");
-        for (auto it = std::sregex_iterator(text.begin(), text.end(), coutMisuse);
-             it != std::sregex_iterator(); ++it) {
-            size_t pos = it->position();
-            size_t len = it->length();
-            SetIndicatorCurrent(4);
-            IndicatorFillRange(pos, len);
-        }
-
-        // 4. Detect 'return 0' without semicolon
-        std::regex returnNoSemi(R"(\breturn\s+0\s*\n)");
-        for (auto it = std::sregex_iterator(text.begin(), text.end(), returnNoSemi);
-             it != std::sregex_iterator(); ++it) {
-            size_t pos = it->position();
-            size_t len = it->length();
-            SetIndicatorCurrent(4);
-            IndicatorFillRange(pos, len);
-        }
-
-        // 5. Highlight 'std::' usage if 'using namespace std;' is missing
-        bool hasNamespaceStd = (text.find("using namespace std;") != std::string::npos);
-        if (!hasNamespaceStd) {
-            std::regex stdUsage(R"(\bstd::)");
-            for (auto it = std::sregex_iterator(text.begin(), text.end(), stdUsage);
-                 it != std::sregex_iterator(); ++it) {
-                size_t pos = it->position();
-                size_t len = it->length();
-                SetIndicatorCurrent(4);
-                IndicatorFillRange(pos, len);
+    // Runs the UPDATEUI stages whose inputs changed, going by the update
+    // flags first so pure scrolls and repaints don't query the caret:
+    //   bracket index     - content
+    //   brace highlight   - caret position, or the brackets
+    //   line selection    - selection
+    //   analysis viewport - vertical scroll, for large documents only
+    //   viewport handler  - vertical scroll, if one is set
+    void OnUpdateUI(int updated) {
+        auto began = std::chrono::steady_clock::now();
+        auto stage = [this](UiStage which, bool needed, auto&& work) {
+            StageStats& stats = m_uiStats.stages[which];
+            if (!needed) {
+                stats.skips++;
+                return;
             }
+            auto start = std::chrono::steady_clock::now();
+            work();
+            stats.Add(std::chrono::steady_clock::now() - start);
+        };
+
+        bool content = (updated & wxSTC_UPDATE_CONTENT) != 0;
+        bool selection = (updated & (wxSTC_UPDATE_CONTENT | wxSTC_UPDATE_SELECTION)) != 0;
+
+        bool braces = IsFeatureEnabled(kBraceMatching);
+        uint64_t bracketVersion = m_brackets.Version();
+        stage(kBracketIndexStage, content && braces, [this] { UpdateBrackets(); });
+
+        int caretPos = selection ? GetCurrentPos() : m_lastCaret;
+        stage(kBraceHighlightStage, braces && (caretPos != m_lastCaret || m_brackets.Version() != bracketVersion),
+              [&] { HighlightBraces(caretPos); });
+        m_lastCaret = caretPos;
+
+        long start = m_lastSelectionStart;
+        long end = m_lastSelectionEnd;
+        if (selection) GetSelection(&start, &end);
+        stage(kLineSelectionStage, start != m_lastSelectionStart || end != m_lastSelectionEnd,
+              [&] { KeepCaretAtLineEnd(start, end); });
+        m_lastSelectionStart = start;
+        m_lastSelectionEnd = end;
+
+        // Large documents are highlighted around the viewport first; keep the
+        // worker's idea of the viewport current while scrolling
+        stage(kViewportStage, (updated & wxSTC_UPDATE_V_SCROLL) && GetTextLength() > kViewportPriorityBytes &&
+                              IsFeatureEnabled(kCodeAnalysis),
+              [this] { UpdateAnalysisViewport(); });
+        stage(kViewportHandlerStage, (updated & wxSTC_UPDATE_V_SCROLL) && m_onViewportChanged,
+              [this] { m_onViewportChanged(); });
+
+        auto elapsed = std::chrono::steady_clock::now() - began;
+        m_uiStats.updates++;
+        m_uiStats.time += elapsed;
+        m_uiStats.worst = std::max<std::chrono::nanoseconds>(m_uiStats.worst, elapsed);
+    }
+
+    // Highlight matching braces. Partners come from the bracket index
+    // rather than BraceMatch, which scans the document; brackets in strings
+    // and comments aren't indexed and so never highlight.
+    void HighlightBraces(int caretPos) {
+        int braceAtCaret = -1;
+        if (caretPos > 0 && m_brackets.IsBracket(caretPos - 1)) {
+            braceAtCaret = caretPos - 1;
+        }
+
+        size_t braceOpposite = braceAtCaret != -1 ? m_brackets.Partner(braceAtCaret) : BracketIndex::npos;
+        if (braceOpposite != BracketIndex::npos) {
+            BraceHighlight(braceAtCaret, static_cast<int>(braceOpposite));
+        } else {
+            BraceBadLight(braceAtCaret);
         }
     }
+
+    // Ensure caret stays at end of line when selecting a whole line
+    void KeepCaretAtLineEnd(long start, long end) {
+        // If selection spans exactly one line from start to end-of-line
+        if (LineFromPosition(start) == LineFromPosition(end) && start != end) {
+            int line = LineFromPosition(start);
+            int lineStart = PositionFromLine(line);
+            int lineEnd = GetLineEndPosition(line);
+
+            if (start == lineStart && end == lineEnd) {
+                // Move caret to end of the line
+                GotoPos(lineEnd);
+            }
+        }
+    }
+
+    // Brings the bracket index up to date and repaints the unmatched
+    // brackets (indicator 5) if they may have changed
+    void UpdateBrackets() {
+        m_brackets.Update(BufferView());
+        if (m_brackets.Version() == m_bracketVersion) return;
+        m_bracketVersion = m_brackets.Version();
+        ApplyIndicator(5, m_bracketMarks, {0, static_cast<size_t>(GetTextLength())}, m_brackets.Unmatched());
+    }
+
+    // Repaints only the parts of `scope` whose indicator value changes
+    void ApplyIndicator(int indicator, IndicatorLayer& layer, const TextRange& scope,
+                        const std::vector<TextRange>& ranges) {
+        IndicatorDelta delta = layer.Update(scope, ranges);
+        SetIndicatorCurrent(indicator);
+        for (const auto& range : delta.clear) {
+            IndicatorClearRange(range.start, range.Length());
+        }
+        for (const auto& range : delta.fill) {
+            IndicatorFillRange(range.start, range.Length());
+        }
+    }
+};
+
+// A report list that holds no rows: each row's text is asked for as it is
+// drawn, so the list costs the same for a million rows as for ten
+class VirtualListCtrl : public wxListCtrl {
+public:
+    using RowText = std::function<wxString(long row, long column)>;
+
+    VirtualListCtrl(wxWindow* parent, RowText rowText)
+            : wxListCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize,
+                         wxLC_REPORT | wxLC_VIRTUAL | wxLC_SINGLE_SEL),
+              m_rowText(std::move(rowText)) {}
+
+private:
+    wxString OnGetItemText(long item, long column) const override { return m_rowText(item, column); }
+
+    RowText m_rowText;
 };
 
 class MyFrame : public wxFrame
@@ -432,7 +940,11 @@ public:
         wxMenu *editMenu = new wxMenu;
         editMenu->Append(wxID_FIND, "&Find\tCtrl+F");
         editMenu->Append(wxID_REPLACE, "&Replace\tCtrl+H");
+        int idFindRegex = wxWindow::NewControlId();
+        editMenu->AppendCheckItem(idFindRegex, "Find with Regular E&xpressions");
         menuBar->Append(editMenu, "&Edit");
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) { SetFindRegex(event.IsChecked()); }, idFindRegex);
+        Bind(wxEVT_UPDATE_UI, [this](wxUpdateUIEvent& event) { event.Check(m_findRegex); }, idFindRegex);
 
         editMenu->AppendSeparator();
         int idStartMacro = wxWindow::NewControlId();
@@ -458,6 +970,51 @@ public:
             if (editor) editor->PlayMacro();
         }, idPlayMacro);
 
+        // --- View Menu ---
+        // Large files are opened with some of these off; see LargeFileMode.h
+        wxMenu* viewMenu = new wxMenu;
+        for (LargeFileFeature feature : kLargeFileFeatures) {
+            int id = wxWindow::NewControlId();
+            viewMenu->AppendCheckItem(id, wxString(FeatureLabel(feature)).Capitalize());
+            Bind(wxEVT_MENU, [this, feature](wxCommandEvent& event) {
+                SetFeature(feature, event.IsChecked());
+            }, id);
+            Bind(wxEVT_UPDATE_UI, [this, feature](wxUpdateUIEvent& event) {
+                auto* editor = GetCurrentEditor();
+                event.Enable(editor != nullptr);
+                event.Check(editor && editor->IsFeatureEnabled(feature) && (feature != kWordWrap || m_wordWrap));
+            }, id);
+        }
+        viewMenu->AppendSeparator();
+        int idAllFeatures = wxWindow::NewControlId();
+        viewMenu->Append(idAllFeatures, "Enable &All Features");
+        viewMenu->AppendSeparator();
+        int idSegmentLongLines = wxWindow::NewControlId();
+        viewMenu->AppendCheckItem(idSegmentLongLines, "&Segment Long Lines");
+        viewMenu->AppendSeparator();
+        int idFindResults = wxWindow::NewControlId();
+        viewMenu->AppendCheckItem(idFindResults, "Find &Results\tCtrl+Shift+F");
+        menuBar->Append(viewMenu, "&View");
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) {
+            m_aui.GetPane(m_results).Show(event.IsChecked());
+            m_aui.Update();
+        }, idFindResults);
+        Bind(wxEVT_UPDATE_UI, [this](wxUpdateUIEvent& event) {
+            event.Check(m_aui.GetPane(m_results).IsShown());
+        }, idFindResults);
+        Bind(wxEVT_MENU, [this](wxCommandEvent&) {
+            auto* editor = GetCurrentEditor();
+            if (!editor) return;
+            for (LargeFileFeature feature : kLargeFileFeatures) editor->SetFeatureEnabled(feature, true);
+        }, idAllFeatures);
+        Bind(wxEVT_MENU, [this](wxCommandEvent& event) {
+            m_segmentLongLines = event.IsChecked();
+            for (size_t i = 0; i < notebook->GetPageCount(); ++i) {
+                auto* page = dynamic_cast<MyEditor*>(notebook->GetPage(i));
+                if (page) page->SetSegmentLongLines(m_segmentLongLines);
+            }
+        }, idSegmentLongLines);
+
 
         // --- Plugins Menu ---
         wxMenu* pluginMenu = new wxMenu;
@@ -466,6 +1023,13 @@ public:
         menuBar->Append(pluginMenu, "&Plugins");
         Bind(wxEVT_MENU, [this](wxCommandEvent&) { OpenMarketplace(); }, idMarketplace);
 
+        // --- Diagnostics Menu ---
+        wxMenu* diagnosticsMenu = new wxMenu;
+        int idAnalysisStats = wxWindow::NewControlId();
+        diagnosticsMenu->Append(idAnalysisStats, "&Analysis Statistics");
+        menuBar->Append(diagnosticsMenu, "&Diagnostics");
+        Bind(wxEVT_MENU, [this](wxCommandEvent&) { ShowAnalysisStats(); }, idAnalysisStats);
+
         SetMenuBar(menuBar);
 
         // --- Toolbar ---
@@ -476,8 +1040,19 @@ public:
         toolbar->AddTool(wxID_SAVE, "Save", wxArtProvider::GetBitmap(wxART_FILE_SAVE, wxART_TOOLBAR));
         toolbar->Realize();
 
+        // Says which features the current document is without, if any
+        CreateStatusBar();
+        LoadLargeFileTiers();
+
         // --- Notebook for Multi-Buffer Tabs ---
         notebook = new wxAuiNotebook(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxAUI_NB_TOP | wxAUI_NB_TAB_MOVE | wxAUI_NB_CLOSE_ON_ALL_TABS);
+        m_aui.SetManagedWindow(this);
+        m_aui.AddPane(notebook, wxAuiPaneInfo().Name("documents").CenterPane());
+
+        // --- Find bar and results ---
+        CreateFindBar();
+        CreateFindResults();
+        m_aui.Update();
 
         // --- Event Bindings ---
         Bind(wxEVT_MENU, &MyFrame::OnNew, this, wxID_NEW);
@@ -489,6 +1064,18 @@ public:
         Bind(wxEVT_MENU, &MyFrame::OnFind, this, wxID_FIND);
         Bind(wxEVT_MENU, &MyFrame::OnReplace, this, wxID_REPLACE);
 
+        notebook->Bind(wxEVT_AUINOTEBOOK_PAGE_CHANGED, [this](wxAuiNotebookEvent& event) {
+            UpdateLargeFileStatus();
+            if (m_findBar->IsShown()) StartFind();
+            event.Skip();
+        });
+
+        // The find bar's search carries on a slice at a time while idle
+        Bind(wxEVT_IDLE, [this](wxIdleEvent& event) {
+            ContinueFind(event);
+            event.Skip();
+        });
+
         Bind(wxEVT_THREAD, [=](wxThreadEvent& e) {
             std::string msg = e.GetString().ToStdString();
             if (msg == "DOWNLOAD_FAILED") {
@@ -501,8 +1088,37 @@ public:
 
     }
 
+    ~MyFrame() override {
+        m_aui.UnInit();
+    }
+
 private:
+    wxAuiManager m_aui;
     wxAuiNotebook* notebook;
+    LargeFilePolicy m_largeFilePolicy;
+    bool m_wordWrap = false;  // applies to every editor
+    bool m_segmentLongLines = false;  // so does this
+    bool m_findRegex = false;  // Find takes a regular expression; see RegexSearcher.h
+
+    // The find bar and its search, in m_findEditor as of m_findVersion
+    wxPanel* m_findBar = nullptr;
+    wxTextCtrl* m_findText = nullptr;
+    wxCheckBox* m_findRegexBox = nullptr;
+    wxStaticText* m_findCount = nullptr;
+    IncrementalFind m_find;
+    MyEditor* m_findEditor = nullptr;  // only compared against unless it is the current editor
+    uint64_t m_findVersion = 0;
+
+    // The search's matches as a list, and the part of the document
+    // indicator 3 currently marks them in, with how many it holds
+    VirtualListCtrl* m_results = nullptr;
+    TextRange m_findPainted;
+    size_t m_findPaintedCount = 0;
+
+    // Bytes searched per idle event once the screen's matches are shown
+    static constexpr size_t kFindSliceBytes = 1 << 20;
+    // Bytes shown either side of a match in a results row
+    static constexpr size_t kResultContextBytes = 120;
 
     MyEditor* GetCurrentEditor()
     {
@@ -511,6 +1127,291 @@ private:
         return dynamic_cast<MyEditor*>(notebook->GetPage(sel));
     }
 
+    MyEditor* CreateEditor()
+    {
+        auto* editor = new MyEditor(notebook);
+        editor->SetLargeFilePolicy(&m_largeFilePolicy);
+        editor->SetWordWrap(m_wordWrap);
+        editor->SetSegmentLongLines(m_segmentLongLines);
+        editor->SetFeaturesChangedHandler([this] { UpdateLargeFileStatus(); });
+        // Find matches are only marked around the screen; keep up with scrolling
+        editor->SetViewportChangedHandler([this, editor] {
+            if (editor == m_findEditor && editor->TextVersion() == m_findVersion) PaintVisibleMatches(editor, true);
+        });
+        return editor;
+    }
+
+    // --- Find bar ---
+    // Searches the current document as the query is typed: the screen
+    // straight away, the rest in idle time. Enter selects the next match and
+    // Escape closes the bar.
+    void CreateFindBar() {
+        m_findBar = new wxPanel(this);
+        m_findText = new wxTextCtrl(m_findBar, wxID_ANY, "", wxDefaultPosition, wxSize(240, -1), wxTE_PROCESS_ENTER);
+        m_findRegexBox = new wxCheckBox(m_findBar, wxID_ANY, "Regular expression");
+        m_findCount = new wxStaticText(m_findBar, wxID_ANY, "");
+        wxButton* closeBtn = new wxButton(m_findBar, wxID_ANY, "Close");
+
+        wxBoxSizer* sizer = new wxBoxSizer(wxHORIZONTAL);
+        sizer->Add(new wxStaticText(m_findBar, wxID_ANY, "Find:"), 0, wxALIGN_CENTER_VERTICAL | wxALL, 5);
+        sizer->Add(m_findText, 0, wxALIGN_CENTER_VERTICAL | wxALL, 5);
+        sizer->Add(m_findRegexBox, 0, wxALIGN_CENTER_VERTICAL | wxALL, 5);
+        sizer->Add(m_findCount, 1, wxALIGN_CENTER_VERTICAL | wxALL, 5);
+        sizer->Add(closeBtn, 0, wxALIGN_CENTER_VERTICAL | wxALL, 5);
+        m_findBar->SetSizerAndFit(sizer);
+        m_aui.AddPane(m_findBar, wxAuiPaneInfo().Name("find").Bottom().Layer(1).CaptionVisible(false)
+                .Floatable(false).Resizable(false).Hide());
+
+        m_findText->Bind(wxEVT_TEXT, [this](wxCommandEvent&) { StartFind(); });
+        m_findText->Bind(wxEVT_TEXT_ENTER, [this](wxCommandEvent&) { SelectNextMatch(); });
+        m_findText->Bind(wxEVT_KEY_DOWN, [this](wxKeyEvent& event) {
+            if (event.GetKeyCode() == WXK_ESCAPE) {
+                CloseFindBar();
+                return;
+            }
+            event.Skip();
+        });
+        m_findRegexBox->Bind(wxEVT_CHECKBOX, [this](wxCommandEvent& event) { SetFindRegex(event.IsChecked()); });
+        closeBtn->Bind(wxEVT_BUTTON, [this](wxCommandEvent&) { CloseFindBar(); });
+    }
+
+    void SetFindRegex(bool regex) {
+        m_findRegex = regex;
+        m_findRegexBox->SetValue(regex);
+        if (m_findBar->IsShown()) StartFind();
+    }
+
+    // The find editor if it is still open
+    MyEditor* FindEditor() {
+        if (!m_findEditor || notebook->GetPageIndex(m_findEditor) == wxNOT_FOUND) return nullptr;
+        return m_findEditor;
+    }
+
+    // Searches the current document for the query, the screen first. The
+    // previous query's matches are narrowed down if the text is unchanged.
+    void StartFind() {
+        auto* editor = GetCurrentEditor();
+        if (editor != m_findEditor || (editor && editor->TextVersion() != m_findVersion)) {
+            // The marks moved with the edits, or belong to another document
+            if (auto* previous = FindEditor()) {
+                ClearFindMarks(previous, {0, static_cast<size_t>(previous->GetTextLength())});
+            }
+            m_find.Reset();
+        }
+        m_findEditor = editor;
+        if (editor) {
+            m_findVersion = editor->TextVersion();
+            m_find.SetQuery(editor->BufferView(), std::string(m_findText->GetValue().utf8_str()), m_findRegex,
+                            editor->ScreenRange());
+            PaintVisibleMatches(editor, true);
+        }
+        UpdateFindCount();
+        UpdateFindResults(true);
+    }
+
+    // Searches the next slice, or starts over if the document was edited or
+    // another one brought forward
+    void ContinueFind(wxIdleEvent& event) {
+        if (!m_findBar->IsShown()) return;
+        auto* editor = GetCurrentEditor();
+        if (editor != m_findEditor || (editor && editor->TextVersion() != m_findVersion)) {
+            StartFind();
+        } else if (editor && !m_find.Done()) {
+            // The last slice may also have moved matches found already
+            bool done = !m_find.Step(editor->BufferView(), kFindSliceBytes);
+            PaintVisibleMatches(editor, done);
+            UpdateFindCount();
+            UpdateFindResults(done);
+        }
+        if (!m_find.Done()) event.RequestMore();
+    }
+
+    // Marks the matches on screen and a screen either side with indicator
+    // 3, and no others: filling millions of ranges would stall Scintilla.
+    // Unless forced, the marks are only redone if matches were found there.
+    void PaintVisibleMatches(MyEditor* editor, bool force) {
+        TextRange screen = editor->ScreenRange();
+        TextRange area{screen.start - std::min(screen.start, screen.Length()), screen.end + screen.Length()};
+        size_t first = m_find.CountBefore(area.start);
+        if (first > 0 && m_find.MatchAt(first - 1).end > area.start) first--;  // runs onto the area
+        size_t last = m_find.CountBefore(area.end);
+        if (!force && last - first == m_findPaintedCount) return;
+
+        ClearFindMarks(editor, m_findPainted);
+        editor->SetIndicatorCurrent(3);
+        for (size_t i = first; i < last; ++i) {
+            TextRange match = m_find.MatchAt(i);
+            editor->IndicatorFillRange(match.start, match.Length());
+            area.start = std::min(area.start, match.start);
+            area.end = std::max(area.end, match.end);
+        }
+        m_findPainted = area;
+        m_findPaintedCount = last - first;
+    }
+
+    void ClearFindMarks(MyEditor* editor, const TextRange& range) {
+        size_t end = std::min(range.end, static_cast<size_t>(editor->GetTextLength()));
+        editor->SetIndicatorCurrent(3);
+        if (range.start < end) editor->IndicatorClearRange(range.start, end - range.start);
+        m_findPainted = TextRange();
+        m_findPaintedCount = 0;
+    }
+
+    void UpdateFindCount() {
+        wxString label;
+        size_t count = m_find.Count();
+        if (!m_find.Error().empty()) {
+            label = "Unsupported regular expression: " + wxString::FromUTF8(m_find.Error().c_str());
+        } else if (!m_find.Query().empty()) {
+            label = count == 0 && m_find.Done() ? wxString("No matches")
+                                                : wxString::Format("%zu match%s", count, count == 1 ? "" : "es");
+            if (!m_find.Done()) label += ", searching...";
+        }
+        m_findCount->SetLabel(label);
+    }
+
+    // Selects the first match after the selection, round to the top
+    void SelectNextMatch() {
+        auto* editor = GetCurrentEditor();
+        if (editor != m_findEditor || (editor && editor->TextVersion() != m_findVersion)) StartFind();
+        if (!editor) return;
+        long start, end;
+        editor->GetSelection(&start, &end);
+        TextRange match = m_find.NextMatch(end);
+        if (match.Empty()) return;
+        editor->SetSelection(match.start, match.end);
+        editor->EnsureCaretVisible();
+    }
+
+    void CloseFindBar() {
+        if (auto* editor = FindEditor()) {
+            ClearFindMarks(editor, {0, static_cast<size_t>(editor->GetTextLength())});
+            editor->SetFocus();
+        }
+        m_find.Reset();
+        m_findEditor = nullptr;
+        UpdateFindResults(true);
+        m_aui.GetPane(m_findBar).Hide();
+        m_aui.Update();
+    }
+
+    // --- Find results ---
+    // The find bar's matches, a row each in document order with the line
+    // and column they are at, docked under the documents. Rows are only made up as they
+    // are drawn, so the list doesn't grow with the matches.
+    void CreateFindResults() {
+        m_results = new VirtualListCtrl(this, [this](long row, long column) { return FindResultText(row, column); });
+        m_results->InsertColumn(0, "Line", wxLIST_FORMAT_RIGHT, 70);
+        m_results->InsertColumn(1, "Col", wxLIST_FORMAT_RIGHT, 50);
+        m_results->InsertColumn(2, "Text", wxLIST_FORMAT_LEFT, 800);
+        m_aui.AddPane(m_results, wxAuiPaneInfo().Name("results").Caption("Find Results").Bottom()
+                .BestSize(700, 200).Hide());
+
+        // Selecting a row shows its match; activating it also goes there
+        m_results->Bind(wxEVT_LIST_ITEM_SELECTED, [this](wxListEvent& event) { ShowMatch(event.GetIndex(), false); });
+        m_results->Bind(wxEVT_LIST_ITEM_ACTIVATED, [this](wxListEvent& event) { ShowMatch(event.GetIndex(), true); });
+    }
+
+    // The rows are redrawn when their matches may have changed, or else
+    // only if there are more of them
+    void UpdateFindResults(bool changed) {
+        long count = static_cast<long>(m_find.Count());
+        if (!changed && count == m_results->GetItemCount()) return;
+        m_results->SetItemCount(count);
+        m_results->Refresh();
+    }
+
+    // Line number, column in characters, or the line's text around the
+    // match with long lines cut short, read from the document when the row
+    // is drawn
+    wxString FindResultText(long row, long column) {
+        auto* editor = FindEditor();
+        if (!editor || editor->TextVersion() != m_findVersion || row < 0 ||
+            static_cast<size_t>(row) >= m_find.Count()) {
+            return wxString();
+        }
+        TextRange match = m_find.MatchAt(row);
+        int line = editor->LineFromPosition(match.start);
+        if (column == 0) return wxString::Format("%d", line + 1);
+
+        std::string_view text = editor->BufferView();
+        size_t lineStart = editor->PositionFromLine(line);
+        if (column == 1) {
+            return wxString::Format("%zu", CountCodePoints(text.substr(lineStart, match.start - lineStart)) + 1);
+        }
+        size_t lineEnd = editor->GetLineEndPosition(line);
+        size_t from = CharStart(text, match.start - std::min(match.start - lineStart, kResultContextBytes));
+        size_t to = CharStart(text, std::min(lineEnd, match.end + kResultContextBytes));
+        wxString shown = wxString::FromUTF8(text.data() + from, to - from);
+        if (from > lineStart) shown.Prepend("...");
+        if (to < lineEnd) shown += "...";
+        return shown;
+    }
+
+    void ShowMatch(long row, bool focus) {
+        auto* editor = GetCurrentEditor();
+        if (!editor || editor != m_findEditor || editor->TextVersion() != m_findVersion || row < 0 ||
+            static_cast<size_t>(row) >= m_find.Count()) {
+            return;
+        }
+        TextRange match = m_find.MatchAt(row);
+        editor->SetSelection(match.start, match.end);
+        editor->EnsureCaretVisible();
+        if (focus) editor->SetFocus();
+    }
+
+    // --- Large-file mode ---
+    // The tiers come from large_file_tiers.json in the working directory if
+    // there is one, e.g.
+    //   [{"name": "Large", "bytes": 16777216, "lines": 250000, "longestLine": 65536,
+    //     "disable": ["wordWrap", "braceMatching"]}]
+    // with features named as in FeatureFromName, and are the defaults otherwise
+    void LoadLargeFileTiers() {
+        std::ifstream in("large_file_tiers.json");
+        if (!in) return;
+
+        std::vector<LargeFileTier> tiers;
+        try {
+            for (const auto& entry : nlohmann::json::parse(in)) {
+                LargeFileTier tier;
+                tier.name = entry.value("name", "Large");
+                tier.bytes = entry.value("bytes", size_t(0));
+                tier.lines = entry.value("lines", size_t(0));
+                tier.longestLine = entry.value("longestLine", size_t(0));
+                for (const auto& name : entry.value("disable", std::vector<std::string>())) {
+                    tier.disabled |= FeatureFromName(name);
+                }
+                tiers.push_back(tier);
+            }
+        } catch (...) {
+            wxMessageBox("Failed to parse large_file_tiers.json; using the default tiers.", "Error",
+                         wxOK | wxICON_ERROR);
+            return;
+        }
+        m_largeFilePolicy.SetTiers(std::move(tiers));
+    }
+
+    void UpdateLargeFileStatus() {
+        auto* editor = GetCurrentEditor();
+        SetStatusText(editor ? editor->LargeFileStatus() : wxString());
+    }
+
+    void SetFeature(LargeFileFeature feature, bool enabled) {
+        auto* editor = GetCurrentEditor();
+        if (!editor) return;
+        if (feature == kWordWrap) {
+            // Wrap is a preference for every editor; checking it also brings
+            // it back where large-file mode turned it off
+            m_wordWrap = enabled;
+            for (size_t i = 0; i < notebook->GetPageCount(); ++i) {
+                if (auto* page = dynamic_cast<MyEditor*>(notebook->GetPage(i))) page->SetWordWrap(enabled);
+            }
+            if (enabled) editor->SetFeatureEnabled(kWordWrap, true);
+            return;
+        }
+        editor->SetFeatureEnabled(feature, enabled);
+    }
+
     // --- Plugin Marketplace Feature ---
     static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* output) {
         output->append((char*)contents, size * nmemb);
@@ -626,9 +1527,66 @@ private:
         dlg.ShowModal();
     }
 
+    void ShowAnalysisStats() {
+        auto* editor = GetCurrentEditor();
+        if (!editor) return;
+
+        const SchedulerStats& stats = editor->GetAnalysisStats();
+        IndicatorStats indicators = editor->GetIndicatorStats();
+        const StylingStats& styling = editor->GetStylingStats();
+        wxString report = wxString::Format(
+                "Edit notifications received: %llu\n"
+                "Analyses run: %llu\n"
+                "Results applied: %llu\n"
+                "Stale results dropped: %llu\n"
+                "Passes cancelled: %llu\n"
+                "\n"
+                "Highlight ranges computed: %llu\n"
+                "Indicator fill calls: %llu\n"
+                "Indicator clear calls: %llu\n"
+                "\n"
+                "Styling requests: %llu\n"
+                "Lines styled: %llu\n"
+                "Lines kept unchanged: %llu",
+                (unsigned long long)stats.eventsReceived, (unsigned long long)stats.analysesRun,
+                (unsigned long long)stats.resultsApplied, (unsigned long long)stats.resultsDropped,
+                (unsigned long long)stats.passesCancelled,
+                (unsigned long long)indicators.rangesRequested, (unsigned long long)indicators.fillCalls,
+                (unsigned long long)indicators.clearCalls,
+                (unsigned long long)styling.passes, (unsigned long long)styling.linesStyled,
+                (unsigned long long)styling.linesSkipped);
+
+        const LintStats& lint = editor->GetLintStats();
+        report += wxString::Format("\n\nError rules: %llu runs over %llu tokens, %.2f ms scanning",
+                                   (unsigned long long)lint.runs, (unsigned long long)lint.tokens,
+                                   lint.scanTime.count() / 1e6);
+        for (const LintRuleStats& rule : lint.rules) {
+            report += wxString::Format("\n  %s: %llu hits, %.2f ms", rule.name, (unsigned long long)rule.hits,
+                                       rule.time.count() / 1e6);
+        }
+
+        const HighlightCacheStats& cache = editor->GetHighlightCacheStats();
+        report += wxString::Format("\n\nHighlight cache: %llu of %llu lines reused (%.1f%%), %llu entries, %.1f KB",
+                                   (unsigned long long)cache.hits, (unsigned long long)cache.lookups,
+                                   cache.lookups ? 100.0 * cache.hits / cache.lookups : 0.0,
+                                   (unsigned long long)cache.entries, cache.bytes / 1024.0);
+
+        const UiUpdateStats& ui = editor->GetUiStats();
+        report += wxString::Format("\n\nUI updates: %llu, %.1f us average, %.1f us worst",
+                                   (unsigned long long)ui.updates,
+                                   ui.updates ? ui.time.count() / 1e3 / ui.updates : 0.0, ui.worst.count() / 1e3);
+        for (const StageStats& stage : ui.stages) {
+            report += wxString::Format("\n  %s: %llu runs, %llu skipped, %.2f ms, %.1f us worst", stage.name,
+                                       (unsigned long long)stage.runs, (unsigned long long)stage.skips,
+                                       stage.time.count() / 1e6, stage.worst.count() / 1e3);
+        }
+
+        wxMessageBox(report, "Analysis Statistics", wxOK | wxICON_INFORMATION);
+    }
+
     void OnNew(wxCommandEvent&)
     {
-        auto* editor = new MyEditor(notebook);
+        auto* editor = CreateEditor();
         notebook->AddPage(editor, "Untitled", true);
 
     }
@@ -641,11 +1599,22 @@ private:
             return;
 
         wxString path = openFileDialog.GetPath();
-        auto* editor = new MyEditor(notebook);
-        editor->LoadFile(path);
+        auto* editor = CreateEditor();
+        bool readAsLatin1 = false;
+        if (!editor->LoadDocument(path, readAsLatin1)) {
+            editor->Destroy();
+            wxMessageBox("Could not read " + path, "Open", wxOK | wxICON_ERROR);
+            return;
+        }
         editor->SetFilename(path);
         notebook->AddPage(editor, path.AfterLast('/'), true);
         editor->SetModified(false);
+        UpdateLargeFileStatus();
+
+        if (readAsLatin1) {
+            wxMessageBox("The file is not valid UTF-8 and was opened as Latin-1.", "Open",
+                         wxOK | wxICON_INFORMATION);
+        }
     }
 
     void OnSave(wxCommandEvent&)
@@ -686,67 +1655,47 @@ private:
     }
 
     void OnFind(wxCommandEvent&) {
-        auto* editor = GetCurrentEditor();
-        if (!editor) return;
-
-        wxTextEntryDialog dlg(this, "Enter text to find:", "Find");
-        if (dlg.ShowModal() != wxID_OK) return;
-
-        wxString query = dlg.GetValue();
-        if (query.IsEmpty()) return;
-
-        // Clear any previous indicator 3 highlights
-        editor->SetIndicatorCurrent(3);
-        editor->IndicatorClearRange(0, editor->GetTextLength());
-
-        // Configure indicator 3 for find highlights
-        editor->IndicatorSetStyle(3, wxSTC_INDIC_ROUNDBOX);
-        editor->IndicatorSetForeground(3, wxColour(255, 255, 0)); // Yellow highlight
-        editor->IndicatorSetAlpha(3, 80);
-
-        std::string text = editor->GetText().ToStdString();
-        std::string search = query.ToStdString();
-
-        size_t pos = text.find(search, 0);
-        bool foundAny = false;
-
-        while (pos != std::string::npos) {
-            editor->SetIndicatorCurrent(3);
-            editor->IndicatorFillRange(pos, search.size());
-            foundAny = true;
-            pos = text.find(search, pos + search.size());
-        }
-
-        if (!foundAny) {
-            wxMessageBox("Text not found.", "Find", wxOK | wxICON_INFORMATION);
-        }
+        m_aui.GetPane(m_findBar).Show();
+        m_aui.Update();
+        m_findText->SetFocus();
+        m_findText->SelectAll();
+        StartFind();
     }
 
     void OnReplace(wxCommandEvent&) {
         auto* editor = GetCurrentEditor();
         if (!editor) return;
 
-        wxTextEntryDialog findDlg(this, "Enter text to find:", "Replace - Step 1");
+        wxTextEntryDialog findDlg(this, m_findRegex ? "Enter regular expression to find:" : "Enter text to find:",
+                                  "Replace - Step 1", m_findText->GetValue());
         if (findDlg.ShowModal() != wxID_OK) return;
 
-        wxString findText = findDlg.GetValue();
-        if (findText.IsEmpty()) return;
+        std::string findText(findDlg.GetValue().utf8_str());
+        if (findText.empty()) return;
 
         wxTextEntryDialog replaceDlg(this, "Enter replacement text:", "Replace - Step 2");
         if (replaceDlg.ShowModal() != wxID_OK) return;
 
-        wxString replaceText = replaceDlg.GetValue();
-
-        int count = 0;
-        long pos = 0;
-        while (true) {
-            pos = editor->FindText(pos, editor->GetTextLength(), findText);
-            if (pos == -1) break;
-            editor->SetTargetStart(pos);
-            editor->SetTargetEnd(pos + findText.length());
-            editor->ReplaceTarget(replaceText);
-            pos += replaceText.length();
-            count++;
+        std::string replaceText(replaceDlg.GetValue().utf8_str());
+
+        // Every match first, as Find would have them, then one edit
+        std::string_view text = editor->BufferView();
+        std::vector<TextRange> matches;
+        if (m_findRegex) {
+            RegexSearcher regex;
+            if (!regex.Compile(findText)) {
+                wxMessageBox("Unsupported regular expression: " + wxString::FromUTF8(regex.Error().c_str()),
+                             "Replace", wxOK | wxICON_ERROR);
+                return;
+            }
+            regex.FindAll(text, {0, text.size()}, matches);
+        } else {
+            FindIgnoringCase(text, findText, matches);
+        }
+        int count = static_cast<int>(matches.size());
+        if (count > 0) {
+            std::string replaced = ReplaceMatches(text, matches, replaceText);
+            editor->ReplaceRange({matches.front().start, matches.back().end}, replaced);
         }
 
         wxMessageBox(wxString::Format("Replaced %d occurrences.", count), "Replace", wxOK | wxICON_INFORMATION);
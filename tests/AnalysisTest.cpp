@@ -0,0 +1,143 @@
+#include "Test.h"
+
+#include <algorithm>
+#include "analysis/DocumentAnalyzer.h"
+#include "analysis/IndicatorLayer.h"
+
+namespace {
+
+// Declarations, their uses, calls, and what the error rules look for, cut
+// up by comments, strings and line breaks
+const char* const kFragments[] = {
+        "int ", "string ", "double ", "count", "x", "ratio", " = ", "0", "1.5", ";", ";\n", ", ", "\n", " ",
+        "{", "}", "(", ")", "f(x);\n", "x = count + 1;\n", "using namespace std;\n", "cout", "std::", "<<", ">>",
+        "return ", "\"ab", "\"", "'", "/*", "*/", "// c\n", "\t", "if (count > 0) ", "int count = 0;\n",
+};
+
+int CountLines(const std::string& text) {
+    return static_cast<int>(std::count(text.begin(), text.end(), '\n')) + 1;
+}
+
+int LineAt(const std::string& text, size_t pos) {
+    return static_cast<int>(std::count(text.begin(), text.begin() + pos, '\n'));
+}
+
+// The three indicators as the editor keeps them
+struct Screen {
+    IndicatorLayer variables;
+    IndicatorLayer functions;
+    IndicatorLayer errors;
+
+    void Apply(const AnalysisResult& result) {
+        variables.Update(result.variableRange, result.variables);
+        functions.Update(result.functionRange, result.functions);
+        errors.Update(result.errorRange, result.errors);
+    }
+    void NoteEdit(const EditRecord& edit) {
+        for (IndicatorLayer* layer : {&variables, &functions, &errors}) {
+            if (edit.inserted) {
+                layer->NoteInsert(edit.position, edit.length);
+            } else {
+                layer->NoteDelete(edit.position, edit.length);
+            }
+        }
+    }
+};
+
+// Analyses `dirty` and works off the backlog, as the worker does between jobs
+void Analyse(DocumentAnalyzer& analyzer, Screen& screen, const std::string& text, const TextRange& dirty) {
+    screen.Apply(analyzer.Analyse(text, dirty, LineAt(text, std::min(dirty.start, text.size())), CountLines(text)));
+    while (analyzer.HasBacklog()) screen.Apply(analyzer.NextSlice(text));
+}
+
+bool SameRanges(const std::vector<TextRange>& a, const std::vector<TextRange>& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const TextRange& x, const TextRange& y) {
+               return x.start == y.start && x.end == y.end;
+           });
+}
+
+// A random insert or delete, applied to the text and turned into the record
+// wxEVT_STC_MODIFIED would give
+EditRecord RandomEdit(std::mt19937& rng, std::string& text) {
+    EditRecord edit;
+    edit.position = text.empty() ? 0 : rng() % (text.size() + 1);
+    edit.inserted = text.empty() || rng() % 2;
+    if (edit.inserted) {
+        std::string inserted = RandomText(rng, kFragments, 1 + rng() % 4);
+        text.insert(edit.position, inserted);
+        edit.length = inserted.size();
+        edit.linesAdded = static_cast<int>(std::count(inserted.begin(), inserted.end(), '\n'));
+    } else {
+        edit.length = std::min<size_t>(1 + rng() % 12, text.size() - edit.position);
+        edit.linesAdded = -static_cast<int>(std::count(text.begin() + edit.position,
+                                                       text.begin() + edit.position + edit.length, '\n'));
+        text.erase(edit.position, edit.length);
+    }
+    edit.line = LineAt(text, edit.position);
+    return edit;
+}
+
+// Random documents, some with lines longer than kLongLineBytes and big
+// enough for full passes to be split over the pool
+std::string RandomDocument(std::mt19937& rng, bool large) {
+    if (!large) return RandomText(rng, kFragments, rng() % 200);
+    std::string text;
+    while (text.size() < 3 * kLongLineBytes) {
+        std::string line = RandomText(rng, kFragments, 64);
+        if (rng() % 4 == 0) {
+            // One long line: the fragments without their line breaks
+            line.clear();
+            while (line.size() < kLongLineBytes + 1000) line += RandomText(rng, kFragments, 64);
+            line.erase(std::remove(line.begin(), line.end(), '\n'), line.end());
+            line += '\n';
+        }
+        text += line;
+    }
+    return text;
+}
+
+} // namespace
+
+// DocumentAnalyzer kept up to date edit by edit, its results applied to the
+// indicators the way the editor applies them, against a fresh full pass
+int TestIncrementalAnalysis() {
+    TestLog log("Incremental analysis");
+    std::mt19937 rng(19);
+    ThreadPool pool(4);
+    for (int round = 0; round < 600; ++round) {
+        bool large = round % 100 == 99;
+        std::string text = RandomDocument(rng, large);
+        DocumentAnalyzer analyzer(pool);
+        Screen screen;
+        Analyse(analyzer, screen, text, {0, text.size()});
+
+        for (int burst = 0; burst < 20; ++burst) {
+            // A burst of edits, analysed once
+            DirtyRange dirty;
+            for (int i = 1 + rng() % 3; i > 0; --i) {
+                EditRecord edit = RandomEdit(rng, text);
+                analyzer.ApplyEdit(edit);
+                screen.NoteEdit(edit);
+                if (edit.inserted) {
+                    dirty.Insert(edit.position, edit.length);
+                } else {
+                    dirty.Delete(edit.position, edit.length);
+                }
+            }
+            Analyse(analyzer, screen, text, dirty.Range());
+
+            DocumentAnalyzer fresh(pool);
+            Screen expected;
+            Analyse(fresh, expected, text, {0, text.size()});
+            log.AddCase();
+            bool same = SameRanges(screen.variables.Applied(), expected.variables.Applied()) &&
+                        SameRanges(screen.functions.Applied(), expected.functions.Applied()) &&
+                        SameRanges(screen.errors.Applied(), expected.errors.Applied());
+            if (!log.Check(same, large ? "in a document of " + std::to_string(text.size()) + " bytes"
+                                       : "after editing to [" + Printable(text) + "]")) {
+                break;
+            }
+        }
+    }
+    return log.Finish();
+}
@@ -0,0 +1,108 @@
+#include "Test.h"
+
+#include <algorithm>
+#include <cstring>
+#include "analysis/BracketIndex.h"
+
+namespace {
+
+// Brackets, and the strings, characters, comments and preprocessor lines
+// that hide them
+const char* const kFragments[] = {
+        "(", ")", "{", "}", "[", "]", "\n", "a", " ", "\"", "'", "/*", "*/", "//", "#x", "\\",
+        "x(", ");\n", "\"(\"", "\n\n",
+};
+
+struct Reference {
+    std::vector<size_t> partner;  // per byte: kNone, kUnmatched or the partner
+    std::vector<TextRange> unmatched;
+};
+
+constexpr size_t kNone = static_cast<size_t>(-1);
+constexpr size_t kUnmatched = static_cast<size_t>(-2);
+
+// Each kind balanced on its own with a stack, over the lexer's punctuation
+Reference MatchBrackets(const std::string& text) {
+    Reference reference;
+    reference.partner.assign(text.size() + 1, kNone);
+    std::vector<size_t> open[3];
+    for (const Token& token : Tokenize(text)) {
+        if (token.kind != TokenKind::Punctuation) continue;
+        char c = text[token.offset];
+        const char* opening = std::strchr("([{", c);
+        const char* closing = std::strchr(")]}", c);
+        if (c == '\0' || (!opening && !closing)) continue;
+
+        std::vector<size_t>& stack = open[opening ? opening - "([{" : closing - ")]}"];
+        reference.partner[token.offset] = kUnmatched;
+        if (opening) {
+            stack.push_back(token.offset);
+        } else if (stack.empty()) {
+            reference.unmatched.push_back({token.offset, token.offset + 1});
+        } else {
+            reference.partner[token.offset] = stack.back();
+            reference.partner[stack.back()] = token.offset;
+            stack.pop_back();
+        }
+    }
+    for (const auto& stack : open) {
+        for (size_t pos : stack) reference.unmatched.push_back({pos, pos + 1});
+    }
+    std::sort(reference.unmatched.begin(), reference.unmatched.end(),
+              [](const TextRange& a, const TextRange& b) { return a.start < b.start; });
+    return reference;
+}
+
+size_t LineAt(const std::string& text, size_t pos) {
+    return std::count(text.begin(), text.begin() + pos, '\n');
+}
+
+} // namespace
+
+// BracketIndex kept up to date across edits, some of them coalesced before
+// an Update, against matching the whole text with a stack per kind. Some
+// documents run to thousands of lines, so edits cross and split blocks.
+int TestBracketIndex() {
+    TestLog log("BracketIndex");
+    std::mt19937 rng(14);
+    for (int round = 0; round < 2000; ++round) {
+        std::string text = RandomText(rng, kFragments, round % 200 == 0 ? 20000 : rng() % 200);
+        BracketIndex index;
+        index.Update(text);
+
+        for (int step = 0; step < 30; ++step) {
+            size_t pos = rng() % (text.size() + 1);
+            if (rng() % 2 && pos < text.size()) {
+                size_t length = std::min<size_t>(1 + rng() % 6, text.size() - pos);
+                int lines = static_cast<int>(std::count(text.begin() + pos, text.begin() + pos + length, '\n'));
+                text.erase(pos, length);
+                index.NoteEdit(LineAt(text, pos), -lines);
+            } else {
+                std::string inserted = RandomText(rng, kFragments, 1 + rng() % 3);
+                int lines = static_cast<int>(std::count(inserted.begin(), inserted.end(), '\n'));
+                text.insert(pos, inserted);
+                index.NoteEdit(LineAt(text, pos), lines);
+            }
+            if (rng() % 3 == 0) continue;  // coalesced with the next edit
+            index.Update(text);
+
+            Reference reference = MatchBrackets(text);
+            log.AddCase();
+            std::string where = text.size() < 200 ? "[" + Printable(text) + "]" : std::to_string(text.size()) + " bytes";
+            bool same = true;
+            for (size_t p = 0; p <= text.size() && same; ++p) {
+                size_t partner = index.Partner(p);
+                size_t got = !index.IsBracket(p) ? kNone : partner == BracketIndex::npos ? kUnmatched : partner;
+                same = log.Check(got == reference.partner[p], "bracket at " + std::to_string(p) + " in " + where);
+            }
+            std::vector<TextRange> unmatched = index.Unmatched();
+            auto sameStart = [](const TextRange& a, const TextRange& b) { return a.start == b.start; };
+            same = same && log.Check(unmatched.size() == reference.unmatched.size() &&
+                                             std::equal(unmatched.begin(), unmatched.end(),
+                                                        reference.unmatched.begin(), sameStart),
+                                     "unmatched brackets in " + where);
+            if (!same) break;
+        }
+    }
+    return log.Finish();
+}
@@ -0,0 +1,43 @@
+#include "Test.h"
+
+#include <regex>
+#include "analysis/DeclarationScanner.h"
+#include "bench/RegexDeclarations.h"
+
+namespace {
+
+// Pieces of declarations and of what merely looks like them. No comments or
+// strings with a declaration in them: the regex would match inside those.
+const char* const kFragments[] = {
+        "int", "bool", "float", "double", "string", "auto", " ", " ", "\n", "\t",
+        "a", "b1", "_x", "count", "=", " = ", ",", ", ", ";", ";\n",
+        "1", "2.5", "1.0f", "(", ")", "+", "f(x)", "\"a b\"", "int x",
+};
+
+} // namespace
+
+// ScanDeclarations against the std::regex recognizer it replaced, on random
+// token strings and on sub-ranges of them
+int TestDeclarationScanner() {
+    TestLog log("DeclarationScanner");
+    std::mt19937 rng(4);
+    const std::regex blankInitializer(R"(=\s*[,;])");  // which only the regex takes
+    for (int round = 0; round < 10000; ++round) {
+        std::string text = RandomText(rng, kFragments, rng() % 30);
+        if (std::regex_search(text, blankInitializer)) continue;
+        std::vector<Token> tokens = Tokenize(text);
+        log.AddCase();
+        log.Check(SameDeclarations(ScanDeclarationsRegex(text, 0, text.size()), ScanDeclarations(text)),
+                  "whole text [" + Printable(text) + "]");
+
+        if (tokens.empty()) continue;
+        size_t first = rng() % tokens.size();
+        size_t last = first + 1 + rng() % (tokens.size() - first);
+        size_t begin = tokens[first].offset;
+        size_t end = tokens[last - 1].End();
+        log.Check(SameDeclarations(ScanDeclarationsRegex(text, begin, end),
+                                   ScanDeclarations(text, tokens, first, last)),
+                  "tokens " + std::to_string(first) + "-" + std::to_string(last) + " of [" + Printable(text) + "]");
+    }
+    return log.Finish();
+}
@@ -0,0 +1,107 @@
+#include "Test.h"
+
+#include <algorithm>
+#include "analysis/IncrementalFind.h"
+
+namespace {
+
+// Non-overlapping occurrences, left to right
+std::vector<TextRange> GreedySearch(const std::string& text, const std::string& query) {
+    std::vector<TextRange> matches;
+    for (size_t pos = text.find(query); pos != std::string::npos; pos = text.find(query, pos + query.size())) {
+        matches.push_back({pos, pos + query.size()});
+    }
+    return matches;
+}
+
+// MatchAt in document order, and CountBefore and NextMatch agreeing with it
+bool Consistent(const IncrementalFind& find, size_t pos) {
+    for (size_t i = 1; i < find.Count(); ++i) {
+        if (find.MatchAt(i - 1).start >= find.MatchAt(i).start) return false;
+    }
+    size_t before = 0;
+    while (before < find.Count() && find.MatchAt(before).start < pos) before++;
+    if (find.CountBefore(pos) != before) return false;
+
+    TextRange next = find.NextMatch(pos);
+    TextRange expected = before < find.Count() ? find.MatchAt(before) : find.Count() ? find.MatchAt(0) : TextRange();
+    return next.start == expected.start && next.end == expected.end;
+}
+
+bool SameMatches(const IncrementalFind& find, const std::vector<TextRange>& expected) {
+    if (find.Count() != expected.size()) return false;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (find.MatchAt(i).start != expected[i].start || find.MatchAt(i).end != expected[i].end) return false;
+    }
+    return true;
+}
+
+std::string RandomLines(std::mt19937& rng, size_t length, int letters) {
+    std::string text;
+    while (text.size() < length) text += rng() % 15 == 0 ? '\n' : static_cast<char>('a' + rng() % letters);
+    return text;
+}
+
+} // namespace
+
+// A query typed a letter at a time, so each extends the last and only its
+// matches are re-checked, with random viewports, slice sizes, resets and
+// stops part way; the matches must be those of a plain greedy search, and
+// consistent with each other after every step. Then regular expressions,
+// some matching over line ends, searched a slice at a time, against one
+// FindAll over the text.
+int TestIncrementalFind() {
+    TestLog log("IncrementalFind");
+    std::mt19937 rng(23);
+    for (int round = 0; round < 20000; ++round) {
+        int letters = 2 + rng() % 3;
+        std::string text = RandomLines(rng, rng() % 300, letters);
+        std::string query = RandomLines(rng, 1 + rng() % 6, letters);
+        query.erase(std::remove(query.begin(), query.end(), '\n'), query.end());
+        if (query.empty()) continue;
+
+        IncrementalFind find;
+        bool ok = true;
+        for (size_t typed = 1; typed <= query.size() && ok; ++typed) {
+            size_t start = text.empty() ? 0 : rng() % (text.size() + 1);
+            TextRange viewport = {start, std::min(text.size(), start + rng() % 50)};
+            if (typed > 1 && rng() % 4 == 0) find.Reset();
+            find.SetQuery(text, query.substr(0, typed), false, viewport);
+            ok = Consistent(find, text.empty() ? 0 : rng() % text.size());
+
+            bool finish = typed == query.size() || rng() % 3 == 0;
+            for (int step = rng() % 4; ok && (step > 0 || (finish && !find.Done())); --step) {
+                find.Step(text, 1 + rng() % 40);
+                ok = Consistent(find, text.empty() ? 0 : rng() % text.size());
+            }
+        }
+        log.AddCase();
+        log.Check(ok && SameMatches(find, GreedySearch(text, query)),
+                  "'" + query + "' in [" + Printable(text) + "]");
+    }
+
+    // Some can run over line ends, and so past where a slice ends
+    const char* const patterns[] = {"a+b", "[ab]c*", "^a", "b$", "(ab|c)+", "a.c",
+                                    "\\s+", "[^a]+", "a\\nb", "b[^c]*a$"};
+    const size_t patternCount = sizeof(patterns) / sizeof(patterns[0]);
+    for (int round = 0; round < 5000; ++round) {
+        std::string text = RandomLines(rng, rng() % 400, 3);
+        if (rng() % 2) std::replace(text.begin(), text.end(), 'c', ' ');
+        std::string pattern = patterns[rng() % patternCount];
+        RegexSearcher searcher;
+        searcher.Compile(pattern);
+        std::vector<TextRange> expected;
+        searcher.FindAll(text, {0, text.size()}, expected);
+
+        // Viewports start on a line, as the editor's do
+        size_t start = text.empty() ? 0 : rng() % text.size();
+        while (start > 0 && text[start - 1] != '\n') start--;
+        IncrementalFind find;
+        find.SetQuery(text, pattern, true, {start, std::min(text.size(), start + rng() % 60)});
+        bool ok = find.Error().empty();
+        while (ok && find.Step(text, 1 + rng() % 50)) ok = Consistent(find, text.empty() ? 0 : rng() % text.size());
+        log.AddCase();
+        log.Check(ok && SameMatches(find, expected), "/" + pattern + "/ in [" + Printable(text) + "]");
+    }
+    return log.Finish();
+}
@@ -0,0 +1,125 @@
+#include "Test.h"
+
+#include <regex>
+#include "analysis/RegexSearcher.h"
+
+namespace {
+
+// A random pattern over a small alphabet, nested at most two groups deep
+std::string RandomPattern(std::mt19937& rng, int depth);
+
+std::string RandomAtom(std::mt19937& rng, int depth) {
+    const char* const atoms[] = {"a", "b", "c", ".", "[ab]", "[^a]", "\\d", "\\s", "\\w"};
+    if (depth < 2 && rng() % 10 == 0) return "(" + RandomPattern(rng, depth + 1) + ")";
+    return atoms[rng() % (sizeof(atoms) / sizeof(atoms[0]))];
+}
+
+std::string RandomPattern(std::mt19937& rng, int depth) {
+    const char* const quantifiers[] = {"", "", "", "*", "+", "?", "{1,2}", "{2}"};
+    std::string pattern;
+    for (int i = 1 + rng() % 3; i > 0; --i) {
+        std::string atom = RandomAtom(rng, depth);
+        // Nothing like (a*)* that std::regex takes exponential time over
+        bool group = atom[0] == '(' && atom.find_first_of("*+?{") != std::string::npos;
+        pattern += atom + (group ? "" : quantifiers[rng() % 8]);
+    }
+    if (depth < 2 && rng() % 4 == 0) pattern += "|" + RandomPattern(rng, depth + 1);
+    return pattern;
+}
+
+// Leftmost-longest, non-overlapping matches in text[begin, end), found by
+// trying every span with std::regex_match, the anchors checked by hand
+std::vector<TextRange> BruteForce(const std::string& text, size_t begin, size_t end, const std::regex& re,
+                                  bool anchorStart, bool anchorEnd) {
+    std::vector<TextRange> matches;
+    for (size_t pos = begin; pos < end;) {
+        size_t found = 0;
+        bool lineStart = pos == 0 || text[pos - 1] == '\n';
+        for (size_t stop = end; stop > pos && (lineStart || !anchorStart); --stop) {
+            if (anchorEnd && stop != text.size() && text[stop] != '\n') continue;
+            if (std::regex_match(text.begin() + pos, text.begin() + stop, re)) {
+                found = stop;
+                break;
+            }
+        }
+        if (found) {
+            matches.push_back({pos, found});
+            pos = found;
+        } else {
+            pos++;
+        }
+    }
+    return matches;
+}
+
+bool SameRanges(const std::vector<TextRange>& a, const std::vector<TextRange>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].start != b[i].start || a[i].end != b[i].end) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+// RegexSearcher against brute force on random patterns, texts and
+// sub-ranges, some with a state cache so small it is flushed all the time;
+// then the patterns it has to refuse
+int TestRegexSearcher() {
+    TestLog log("RegexSearcher");
+    std::mt19937 rng(22);
+    for (int round = 0; round < 3000; ++round) {
+        std::string body = RandomPattern(rng, 0);
+        bool anchorStart = rng() % 5 == 0;
+        bool anchorEnd = rng() % 5 == 0;
+        std::string pattern = (anchorStart ? "^" : "") + body + (anchorEnd ? "$" : "");
+
+        RegexSearcher searcher;
+        bool topLevelAlternation = false;
+        for (size_t i = 0, depth = 0; i < body.size(); ++i) {
+            if (body[i] == '(') depth++;
+            if (body[i] == ')') depth--;
+            if (body[i] == '|' && depth == 0) topLevelAlternation = true;
+        }
+        if ((anchorStart || anchorEnd) && topLevelAlternation) {
+            log.AddCase();
+            log.Check(!searcher.Compile(pattern), "/" + pattern + "/ should be refused");
+            continue;
+        }
+        if (!searcher.Compile(pattern)) continue;  // e.g. it only matches empty text
+        if (rng() % 3 == 0) searcher.SetCacheLimit(64);
+        std::regex re(body);
+
+        for (int i = 0; i < 10; ++i) {
+            const char alphabet[] = "ab c1\n";
+            std::string text;
+            for (size_t length = rng() % 30; text.size() < length;) text += alphabet[rng() % 6];
+            size_t begin = 0;
+            size_t end = text.size();
+            if (rng() % 2) {
+                begin = rng() % (text.size() + 1);
+                end = begin + rng() % (text.size() - begin + 1);
+            }
+
+            std::vector<TextRange> found;
+            searcher.FindAll(text, {begin, end}, found);
+            log.AddCase();
+            log.Check(SameRanges(found, BruteForce(text, begin, end, re, anchorStart, anchorEnd)),
+                      "/" + pattern + "/ in [" + Printable(text) + "] " + std::to_string(begin) + "-" +
+                              std::to_string(end));
+        }
+    }
+
+    // Patterns that would have the parser recurse too deep, or expand
+    // without bound, are refused rather than crashing or running away
+    std::string deep = std::string(100000, '(') + "a" + std::string(100000, ')');
+    std::string empties;
+    for (int i = 0; i < 100000; ++i) empties += "()";
+    for (const std::string& pattern : {deep, empties + "a", std::string("((a{1000}){1000}){1000}")}) {
+        RegexSearcher searcher;
+        log.AddCase();
+        log.Check(!searcher.Compile(pattern) && !searcher.Error().empty(),
+                  "a pattern of " + std::to_string(pattern.size()) + " bytes should be refused");
+    }
+    return log.Finish();
+}
@@ -0,0 +1,101 @@
+#include "Test.h"
+
+#include <cctype>
+#include "analysis/BulkReplace.h"
+
+namespace {
+
+// FindIgnoringCase folds the text a chunk of this many bytes at a time
+constexpr size_t kChunkBytes = 1 << 20;
+
+// Letters of both cases, the bytes either side of A-Z and a-z, which aren't
+// letters, and a non-ASCII character, which folding leaves alone
+const char* const kFragments[] = {"a", "A", "b", "B", "ab", "Ba", "c", "@", "[", "`", "{", "\n", "\xC3\x84"};
+
+std::string Folded(std::string text) {
+    for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return text;
+}
+
+std::string RandomCase(std::mt19937& rng, std::string text) {
+    for (char& c : text) {
+        if (rng() % 2) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+// The text with every match replaced: the ones a plain find on the folded
+// text gives, left to right without overlapping
+std::string NaiveReplace(const std::string& text, const std::string& needle, const std::string& replacement,
+                         std::vector<TextRange>& matches) {
+    std::string folded = Folded(text);
+    std::string foldedNeedle = Folded(needle);
+    std::string replaced;
+    size_t pos = 0;
+    for (size_t hit = folded.find(foldedNeedle); hit != std::string::npos;
+         hit = folded.find(foldedNeedle, hit + needle.size())) {
+        matches.push_back({hit, hit + needle.size()});
+        replaced.append(text, pos, hit - pos);
+        replaced += replacement;
+        pos = hit + needle.size();
+    }
+    replaced.append(text, pos, std::string::npos);
+    return replaced;
+}
+
+bool SameRanges(const std::vector<TextRange>& a, const std::vector<TextRange>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].start != b[i].start || a[i].end != b[i].end) return false;
+    }
+    return true;
+}
+
+void CheckReplace(TestLog& log, const std::string& text, const std::string& needle, const std::string& detail) {
+    const std::string replacement = "<" + needle.substr(0, needle.size() / 2) + ">";
+    std::vector<TextRange> expected;
+    std::string replaced = NaiveReplace(text, needle, replacement, expected);
+
+    std::vector<TextRange> found;
+    FindIgnoringCase(text, needle, found);
+    log.AddCase();
+    if (!log.Check(SameRanges(found, expected), "matches of '" + Printable(needle) + "' in " + detail)) return;
+
+    // ReplaceMatches rebuilds the span from the first match to the last
+    std::string spliced = text;
+    if (!found.empty()) {
+        spliced = text.substr(0, found.front().start) + ReplaceMatches(text, found, replacement) +
+                  text.substr(found.back().end);
+    }
+    log.Check(spliced == replaced, "replacing '" + Printable(needle) + "' in " + detail);
+}
+
+} // namespace
+
+// FindIgnoringCase and ReplaceMatches against folding the whole text and a
+// plain find and replace. Short texts, then texts of two chunks and more
+// with random-case copies of the needle planted on the chunk boundaries:
+// starting on one, ending on one, and straddling one, including starting
+// n - 1 bytes before it, the whole overlap the chunk before reads on into.
+int TestBulkReplace() {
+    TestLog log("BulkReplace");
+    std::mt19937 rng(25);
+    for (int round = 0; round < 20000; ++round) {
+        std::string text = RandomText(rng, kFragments, rng() % 40);
+        std::string needle = RandomText(rng, kFragments, 1 + rng() % 3);
+        CheckReplace(log, text, needle, "[" + Printable(text) + "]");
+    }
+
+    for (int round = 0; round < 24; ++round) {
+        std::string needle = RandomCase(rng, RandomText(rng, kFragments, 2 + rng() % 4));
+        const size_t n = needle.size();
+        std::string text = RandomText(rng, kFragments, 2 * kChunkBytes + rng() % 4096);
+        for (size_t boundary = kChunkBytes; boundary + n < text.size(); boundary += kChunkBytes) {
+            size_t before = round % 3 == 0 ? n - 1 : rng() % (n + 1);
+            text.replace(boundary - before, n, RandomCase(rng, needle));
+        }
+        CheckReplace(log, text, needle, "a text of " + std::to_string(text.size()) + " bytes, round " +
+                                            std::to_string(round));
+    }
+    return log.Finish();
+}
@@ -0,0 +1,58 @@
+#ifndef GROUP56_WORK_TEST_H
+#define GROUP56_WORK_TEST_H
+
+#include <cstdio>
+#include <random>
+#include <string>
+
+// Shared helpers for Group56_tests. Each test checks a piece of the
+// analysis code against a plain reference implementation on many random
+// inputs, with a fixed seed so a failure comes back on the next run.
+
+// The failed checks of one test: all are counted, the first few printed
+class TestLog {
+public:
+    explicit TestLog(const char* name) : m_name(name) {}
+
+    // ok; if not, a failure described by `detail`
+    bool Check(bool ok, const std::string& detail) {
+        if (!ok && m_failures++ < kPrinted) printf("  %s: %s\n", m_name, detail.c_str());
+        return ok;
+    }
+    void AddCase() { m_cases++; }
+
+    // Prints the outcome and returns the number of failures
+    int Finish() const {
+        printf("%-24s %10zu cases %8d failed\n", m_name, m_cases, m_failures);
+        return m_failures;
+    }
+
+private:
+    static constexpr int kPrinted = 5;
+
+    const char* m_name;
+    size_t m_cases = 0;
+    int m_failures = 0;
+};
+
+// `count` fragments picked at random and joined
+template <size_t N>
+std::string RandomText(std::mt19937& rng, const char* const (&fragments)[N], size_t count) {
+    std::string text;
+    for (size_t i = 0; i < count; ++i) text += fragments[rng() % N];
+    return text;
+}
+
+// Newlines and backslashes spelled out, for failure messages
+std::string Printable(const std::string& text);
+
+// Each returns its number of failed checks
+int TestBracketIndex();
+int TestBulkReplace();
+int TestDeclarationScanner();
+int TestIncrementalAnalysis();
+int TestIncrementalFind();
+int TestRegexSearcher();
+int TestUtf8();
+
+#endif //GROUP56_WORK_TEST_H
@@ -0,0 +1,29 @@
+#include "Test.h"
+
+std::string Printable(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '\n') {
+            out += "\\n";
+        } else if (c == '\\') {
+            out += "\\\\";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+// Group56_tests: runs every test and fails if any check did
+int main() {
+    int failures = 0;
+    failures += TestDeclarationScanner();
+    failures += TestUtf8();
+    failures += TestIncrementalAnalysis();
+    failures += TestBracketIndex();
+    failures += TestRegexSearcher();
+    failures += TestIncrementalFind();
+    failures += TestBulkReplace();
+    printf(failures ? "%d checks failed\n" : "all tests passed\n", failures);
+    return failures ? 1 : 0;
+}
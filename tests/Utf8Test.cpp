@@ -0,0 +1,87 @@
+#include "Test.h"
+
+#include "analysis/Utf8.h"
+
+namespace {
+
+// Length of the well-formed sequence starting at pos, or 0 if there is
+// none, going by the table of well-formed byte sequences in the Unicode
+// standard (section 3.9), as a strict decoder does
+size_t SequenceLength(const std::string& text, size_t pos) {
+    auto byte = [&](size_t i) { return pos + i < text.size() ? static_cast<unsigned char>(text[pos + i]) : -1; };
+    auto in = [](int b, int lo, int hi) { return b >= lo && b <= hi; };
+    int b0 = byte(0);
+    if (b0 < 0x80) return 1;
+    if (in(b0, 0xC2, 0xDF)) return in(byte(1), 0x80, 0xBF) ? 2 : 0;
+
+    int lo = 0x80;
+    int hi = 0xBF;
+    if (b0 == 0xE0) lo = 0xA0;
+    if (b0 == 0xED) hi = 0x9F;
+    if (b0 == 0xF0) lo = 0x90;
+    if (b0 == 0xF4) hi = 0x8F;
+    if (in(b0, 0xE0, 0xEF)) return in(byte(1), lo, hi) && in(byte(2), 0x80, 0xBF) ? 3 : 0;
+    if (in(b0, 0xF0, 0xF4)) {
+        return in(byte(1), lo, hi) && in(byte(2), 0x80, 0xBF) && in(byte(3), 0x80, 0xBF) ? 4 : 0;
+    }
+    return 0;
+}
+
+size_t FindInvalidReference(const std::string& text) {
+    for (size_t pos = 0; pos < text.size();) {
+        size_t length = SequenceLength(text, pos);
+        if (length == 0) return pos;
+        pos += length;
+    }
+    return std::string::npos;
+}
+
+// Long ASCII runs for the vector path, well-formed characters of every
+// length, and the ill-formed ones: stray continuations, overlongs,
+// surrogates, code points past U+10FFFF, bytes never used, cut sequences
+const char* const kFragments[] = {
+        "a", "int x = 0;\n", "0123456789abcdefghijklmnopqrstuvwxyz", "\t",
+        "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "\xEF\xBF\xBF", "\xF4\x8F\xBF\xBF", "\xED\x9F\xBF",
+        "\x80", "\xBF", "\xC0\x80", "\xC1\xBF", "\xE0\x80\x80", "\xE0\x9F\xBF", "\xF0\x8F\xBF\xBF",
+        "\xED\xA0\x80", "\xED\xBF\xBF", "\xF4\x90\x80\x80", "\xF5\x80\x80\x80", "\xFF", "\xFE",
+        "\xC3", "\xE2\x82", "\xF0\x9F\x98",
+};
+
+} // namespace
+
+// FindInvalidUtf8 against a strict decoder, and CountCodePoints,
+// Latin1ToUtf8 and CharStart against their definitions
+int TestUtf8() {
+    TestLog log("Utf8");
+    std::mt19937 rng(10);
+    for (int round = 0; round < 20000; ++round) {
+        // Mostly valid text, so the first error is often deep in
+        std::string text = RandomText(rng, kFragments, rng() % 12);
+        if (rng() % 2) {
+            std::string valid = RandomText(rng, kFragments, rng() % 60);
+            text = valid.substr(0, FindInvalidReference(valid)) + text;
+        }
+        log.AddCase();
+        size_t expected = FindInvalidReference(text);
+        size_t found = FindInvalidUtf8(text);
+        log.Check(found == expected, "first invalid byte " + std::to_string(found) + ", not " +
+                                             std::to_string(expected) + ", in " + std::to_string(text.size()) +
+                                             " bytes");
+
+        std::string valid = text.substr(0, expected);
+        size_t codePoints = 0;
+        for (size_t pos = 0; pos < valid.size(); pos += SequenceLength(valid, pos)) codePoints++;
+        log.Check(CountCodePoints(valid) == codePoints, "code point count");
+        for (size_t pos = 0; pos <= valid.size(); ++pos) {
+            // A lead byte, or the end, and the character there covers pos
+            size_t start = CharStart(valid, pos);
+            bool lead = start == valid.size() || (static_cast<unsigned char>(valid[start]) & 0xC0) != 0x80;
+            bool ok = start <= pos && lead && (start == pos || start + SequenceLength(valid, start) > pos);
+            if (!log.Check(ok, "CharStart at " + std::to_string(pos))) break;
+        }
+
+        std::string converted = Latin1ToUtf8(text);
+        log.Check(IsValidUtf8(converted) && CountCodePoints(converted) == text.size(), "Latin-1 conversion");
+    }
+    return log.Finish();
+}